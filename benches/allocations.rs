@@ -0,0 +1,188 @@
+//! Construction cost (time, allocations, bytes) of the stretcher and DSP objects, and a
+//! check that the steady-state processing paths never allocate.
+//!
+//! Rust allocations are counted with a counting global allocator and C++ allocations
+//! with `CxxAllocations`, which needs the `custom-allocator` feature. Exits with an
+//! error if any steady-state path allocates, so it can gate CI.
+//!
+//! Run with `cargo bench --bench allocations --features custom-allocator`.
+
+mod common;
+
+use ssstretch::dsp::delay::Delay;
+use ssstretch::dsp::fft::{RealFFT, FFT};
+use ssstretch::util::buffer::get_channel_slices_mut;
+use ssstretch::{BiquadFilter, CxxAllocations, Stretch, StretchBuilder};
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::hint::black_box;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+struct Counting;
+
+static RUST_ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+static RUST_BYTES: AtomicU64 = AtomicU64::new(0);
+
+unsafe impl GlobalAlloc for Counting {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        RUST_ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        RUST_BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        RUST_ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        RUST_BYTES.fetch_add(new_size as u64, Ordering::Relaxed);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: Counting = Counting;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const FRAMES: usize = 256;
+const STEADY_CALLS: usize = 200;
+
+/// Allocations (Rust and C++) made while running an operation.
+#[derive(Clone, Copy, Default)]
+struct Allocations {
+    rust: u64,
+    rust_bytes: u64,
+    cxx: u64,
+    cxx_bytes: u64,
+}
+
+impl Allocations {
+    fn count<R>(f: impl FnOnce() -> R) -> (Self, R) {
+        let rust = RUST_ALLOCATIONS.load(Ordering::Relaxed);
+        let rust_bytes = RUST_BYTES.load(Ordering::Relaxed);
+        let cxx = CxxAllocations::now();
+        let result = f();
+        let cxx = CxxAllocations::now().since(&cxx);
+        let counts = Self {
+            rust: RUST_ALLOCATIONS.load(Ordering::Relaxed) - rust,
+            rust_bytes: RUST_BYTES.load(Ordering::Relaxed) - rust_bytes,
+            cxx: cxx.count,
+            cxx_bytes: cxx.bytes,
+        };
+        (counts, result)
+    }
+
+    fn total(&self) -> u64 {
+        self.rust + self.cxx
+    }
+}
+
+/// Fastest of a few runs of a constructor, with the allocations of the last one.
+fn construct<R>(name: &str, mut f: impl FnMut() -> R) {
+    let mut best = Duration::MAX;
+    let mut allocations = Allocations::default();
+    for _ in 0..5 {
+        let start = Instant::now();
+        let (counts, result) = Allocations::count(&mut f);
+        best = best.min(start.elapsed());
+        allocations = counts;
+        // Dropped outside the measurement
+        drop(black_box(result));
+    }
+    println!(
+        "{:>34} {:>10.1}us {:>7} {:>11} {:>7} {:>11}",
+        name,
+        best.as_secs_f64() * 1e6,
+        allocations.rust,
+        common::kib(allocations.rust_bytes as usize),
+        allocations.cxx,
+        common::kib(allocations.cxx_bytes as usize),
+    );
+}
+
+/// Run a processing path `STEADY_CALLS` times after warming it up; returns whether it
+/// stayed allocation-free.
+fn steady(name: &str, mut f: impl FnMut()) -> bool {
+    for _ in 0..STEADY_CALLS {
+        f();
+    }
+    let (allocations, ()) = Allocations::count(|| {
+        for _ in 0..STEADY_CALLS {
+            f();
+        }
+    });
+    let ok = allocations.total() == 0;
+    println!(
+        "{:>34} {:>7} {:>7}   {}",
+        name,
+        allocations.rust,
+        allocations.cxx,
+        if ok { "ok" } else { "ALLOCATES" }
+    );
+    ok
+}
+
+fn main() {
+    println!(
+        "{:>34} {:>12} {:>7} {:>11} {:>7} {:>11}",
+        "construction", "time", "rust", "rust bytes", "c++", "c++ bytes"
+    );
+    construct("Stretch::<2>::new", || Stretch::<CHANNELS>::new(SAMPLE_RATE));
+    construct("StretchBuilder preset_cheaper", || {
+        StretchBuilder::<CHANNELS>::new().preset_cheaper(SAMPLE_RATE).build()
+    });
+    construct("StretchBuilder configure(4096, 1024)", || {
+        StretchBuilder::<CHANNELS>::new().configure(4096, 1024).build()
+    });
+    let mut stretch = Stretch::<CHANNELS>::new(SAMPLE_RATE);
+    construct("Stretch::reset", || stretch.reset());
+    construct("BiquadFilter::new", BiquadFilter::new);
+    construct("Delay::new(4800)", || Delay::new(4800));
+    construct("FFT::new(4096)", || FFT::new(4096));
+    construct("RealFFT::new(4096)", || RealFFT::new(4096));
+
+    println!();
+    println!("{:>34} {:>7} {:>7}", "steady state", "rust", "c++");
+    let input = common::noise(CHANNELS, FRAMES, 1);
+    let mut output = vec![vec![0.0f32; FRAMES]; CHANNELS];
+    let mut ok = true;
+
+    ok &= steady("Stretch::process", || {
+        let mut outputs = get_channel_slices_mut::<CHANNELS>(&mut output);
+        stretch.process([&input[0][..], &input[1][..]], &mut outputs);
+    });
+    ok &= steady("Stretch::process (transposed)", || {
+        stretch.set_transpose_semitones(3.0, None);
+        let mut outputs = get_channel_slices_mut::<CHANNELS>(&mut output);
+        stretch.process([&input[0][..], &input[1][..]], &mut outputs);
+    });
+    ok &= steady("Stretch::process_vec", || {
+        stretch.process_vec(&input, FRAMES as i32, &mut output, FRAMES as i32);
+    });
+    ok &= steady("Stretch::seek", || {
+        stretch.seek([&input[0][..], &input[1][..]], 1.0);
+    });
+    ok &= steady("Stretch::flush", || {
+        let [left, right] = &mut output[..] else { unreachable!() };
+        stretch.flush([&mut left[..], &mut right[..]]);
+    });
+
+    let mut filter = BiquadFilter::new();
+    filter.lowpass(0.1, 0.7, None);
+    ok &= steady("BiquadFilter::process_buffer", || {
+        filter.process_buffer(&input[0], &mut output[0]);
+    });
+    let mut delay = Delay::new(4800);
+    ok &= steady("Delay::process_buffer", || {
+        delay.process_buffer(&input[0], &mut output[0], 1234.5);
+    });
+
+    println!();
+    println!("peak RSS: {}", common::mib(common::peak_rss()));
+    if !ok {
+        eprintln!("a steady-state path allocated");
+        std::process::exit(1);
+    }
+}
@@ -0,0 +1,135 @@
+//! Worst-case per-callback time, simulating an audio device: fixed callback sizes from
+//! 32 to 2048 frames plus randomly jittered ones, at several stretch ratios and
+//! transposes, for every preset. Reports p50/p99/p99.9/max call time and the fraction
+//! of calls over the realtime deadline (the duration of the callback's output).
+//!
+//! Times are collected with `DeadlineMonitor`, so percentiles have its ~6% resolution.
+//!
+//! Run with `cargo bench --bench callback_latency`.
+
+mod common;
+
+use common::Rng;
+use ssstretch::{DeadlineMonitor, Stretch, StretchBuilder};
+use std::array;
+use std::hint::black_box;
+use std::sync::Arc;
+use std::time::Duration;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+// Output audio rendered per configuration
+const SECONDS: usize = 5;
+const FIXED_FRAMES: [usize; 7] = [32, 64, 128, 256, 512, 1024, 2048];
+const JITTER_FRAMES: (usize, usize) = (32, 2048);
+
+#[derive(Clone, Copy)]
+enum Callbacks {
+    Fixed(usize),
+    Jittered,
+}
+
+/// Output frames per second of input, and transpose in semitones.
+const CASES: [(f64, f32); 4] = [(1.0, 0.0), (0.75, 0.0), (1.5, 0.0), (1.0, 7.0)];
+
+fn build(preset: &str) -> Stretch<CHANNELS> {
+    let builder = StretchBuilder::<CHANNELS>::new();
+    match preset {
+        "default" => builder.preset_default(SAMPLE_RATE),
+        _ => builder.preset_cheaper(SAMPLE_RATE),
+    }
+    .build()
+}
+
+fn run(
+    stretch: &mut Stretch<CHANNELS>,
+    input: &[Vec<f32>],
+    callbacks: Callbacks,
+    ratio: f64,
+    monitor: &Arc<DeadlineMonitor>,
+) {
+    let mut rng = Rng::new(11);
+    let mut output = vec![vec![0.0f32; JITTER_FRAMES.1]; CHANNELS];
+    let total_out = SAMPLE_RATE as usize * SECONDS;
+
+    // Warm up, then only time the rest
+    stretch.set_monitor(None);
+    let mut produced = 0;
+    let mut consumed = 0.0f64;
+    while produced < total_out {
+        if produced >= total_out / 10 && stretch.monitor().is_none() {
+            stretch.set_monitor(Some(monitor.clone()));
+        }
+        let frames = match callbacks {
+            Callbacks::Fixed(frames) => frames,
+            Callbacks::Jittered => rng.range(JITTER_FRAMES.0, JITTER_FRAMES.1),
+        };
+        // Carry the fractional input position so the overall ratio is exact
+        let start = consumed as usize;
+        consumed += frames as f64 / ratio;
+        let end = consumed as usize;
+
+        let mut channels = output.iter_mut();
+        let mut outputs: [&mut [f32]; CHANNELS] =
+            array::from_fn(|_| &mut channels.next().unwrap()[..frames]);
+        stretch.process(
+            array::from_fn(|channel| &input[channel][start..end]),
+            &mut outputs,
+        );
+        black_box(&outputs[0][0]);
+        produced += frames;
+    }
+    stretch.set_monitor(None);
+}
+
+fn micros(duration: Duration) -> f64 {
+    duration.as_secs_f64() * 1e6
+}
+
+fn main() {
+    // Enough input for the slowest ratio
+    let input = common::noise(CHANNELS, SAMPLE_RATE as usize * SECONDS * 2 + JITTER_FRAMES.1, 5);
+
+    println!(
+        "{:>8} {:>8} {:>6} {:>6} {:>9} {:>9} {:>9} {:>9} {:>9} {:>8}",
+        "preset", "frames", "ratio", "semis", "p50 us", "p99 us", "p99.9 us", "max us", "deadline", "missed"
+    );
+    for preset in ["default", "cheaper"] {
+        let mut stretch = build(preset);
+        for (ratio, semitones) in CASES {
+            stretch.set_transpose_semitones(semitones, None);
+            let callbacks = FIXED_FRAMES
+                .iter()
+                .map(|&frames| Callbacks::Fixed(frames))
+                .chain([Callbacks::Jittered]);
+            for callbacks in callbacks {
+                stretch.reset();
+                let monitor = Arc::new(DeadlineMonitor::new(SAMPLE_RATE as f64));
+                run(&mut stretch, &input, callbacks, ratio, &monitor);
+
+                let snapshot = monitor.snapshot();
+                let (frames, deadline) = match callbacks {
+                    Callbacks::Fixed(frames) => (frames.to_string(), micros(monitor.deadline(frames))),
+                    Callbacks::Jittered => (
+                        format!("{}-{}", JITTER_FRAMES.0, JITTER_FRAMES.1),
+                        micros(monitor.deadline(JITTER_FRAMES.0)),
+                    ),
+                };
+                println!(
+                    "{:>8} {:>8} {:>6.2} {:>6.1} {:>9.1} {:>9.1} {:>9.1} {:>9.1} {:>9.1} {:>7.3}%",
+                    preset,
+                    frames,
+                    ratio,
+                    semitones,
+                    micros(snapshot.percentile(0.5)),
+                    micros(snapshot.percentile(0.99)),
+                    micros(snapshot.percentile(0.999)),
+                    micros(snapshot.max),
+                    deadline,
+                    100.0 * snapshot.overrun_fraction(),
+                );
+            }
+        }
+    }
+    println!("(jittered rows show the deadline of the shortest callback; misses use each call's own)");
+}
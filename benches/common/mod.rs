@@ -0,0 +1,79 @@
+//! Helpers shared by the benchmark binaries (each bench uses a subset).
+#![allow(dead_code)]
+
+use std::time::{Duration, Instant};
+
+/// Deterministic xorshift32 generator.
+pub struct Rng(u32);
+
+impl Rng {
+    pub fn new(seed: u32) -> Self {
+        Self(seed.max(1))
+    }
+
+    pub fn next_u32(&mut self) -> u32 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 17;
+        self.0 ^= self.0 << 5;
+        self.0
+    }
+
+    /// Uniform in [-1, 1).
+    pub fn signed(&mut self) -> f32 {
+        self.next_u32() as f32 / u32::MAX as f32 * 2.0 - 1.0
+    }
+
+    /// Uniform in `low..=high`.
+    pub fn range(&mut self, low: usize, high: usize) -> usize {
+        low + self.next_u32() as usize % (high - low + 1)
+    }
+}
+
+/// Deterministic white noise in [-1, 1), one Vec per channel.
+pub fn noise(channels: usize, samples: usize, seed: u32) -> Vec<Vec<f32>> {
+    let mut rng = Rng::new(seed);
+    (0..channels)
+        .map(|_| (0..samples).map(|_| rng.signed()).collect())
+        .collect()
+}
+
+/// Run `f` once to warm up, then `runs` more times, returning the fastest run.
+pub fn best_of<F: FnMut()>(runs: usize, mut f: F) -> Duration {
+    f();
+    (0..runs)
+        .map(|_| {
+            let start = Instant::now();
+            f();
+            start.elapsed()
+        })
+        .min()
+        .unwrap_or_default()
+}
+
+/// Format a byte count as KiB with one decimal place.
+pub fn kib(bytes: usize) -> String {
+    format!("{:.1} KiB", bytes as f64 / 1024.0)
+}
+
+/// A field of `/proc/self/status` in bytes (Linux only).
+fn proc_status_bytes(field: &str) -> Option<usize> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|line| line.starts_with(field))?;
+    let kib: usize = line[field.len()..].trim().trim_end_matches("kB").trim().parse().ok()?;
+    Some(kib * 1024)
+}
+
+/// Current resident set size, if the platform reports it.
+pub fn rss() -> Option<usize> {
+    proc_status_bytes("VmRSS:")
+}
+
+/// Peak resident set size so far, if the platform reports it.
+pub fn peak_rss() -> Option<usize> {
+    proc_status_bytes("VmHWM:")
+}
+
+/// Format an optional byte count as MiB.
+pub fn mib(bytes: Option<usize>) -> String {
+    bytes.map_or("n/a".into(), |bytes| format!("{:.1} MiB", bytes as f64 / (1024.0 * 1024.0)))
+}
@@ -0,0 +1,43 @@
+//! Throughput of each instruction set the C++ core was built for on this CPU.
+//!
+//! Run with `cargo bench --bench cpu_dispatch --features cpu-dispatch`; without the
+//! feature only the baseline build is listed.
+
+mod common;
+
+use ssstretch::cpu;
+use ssstretch::Stretch;
+use std::hint::black_box;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const SECONDS: usize = 20;
+
+fn main() {
+    let samples = SAMPLE_RATE as usize * SECONDS;
+    let input = common::noise(CHANNELS, samples, 3);
+    let mut output = vec![vec![0.0f32; samples * 3 / 2]; CHANNELS];
+    let mut stretch = Stretch::<CHANNELS>::new(SAMPLE_RATE);
+
+    println!("best available: {}", cpu::best_isa());
+    println!("{:>10} {:>12} {:>10} {:>9}", "isa", "time", "realtime", "speedup");
+
+    let mut baseline = None;
+    for isa in cpu::supported_isas() {
+        assert!(cpu::select_isa(isa));
+        let time = common::best_of(3, || {
+            stretch.reset();
+            stretch.process_vec(&input, samples as i32, &mut output, (samples * 3 / 2) as i32);
+            black_box(&output[0][0]);
+        });
+        let baseline_time = *baseline.get_or_insert(time);
+        println!(
+            "{:>10} {:>10.1}ms {:>9.1}x {:>8.2}x",
+            isa.to_string(),
+            time.as_secs_f64() * 1e3,
+            SECONDS as f64 / time.as_secs_f64(),
+            baseline_time.as_secs_f64() / time.as_secs_f64(),
+        );
+    }
+    cpu::select_isa(cpu::best_isa());
+}
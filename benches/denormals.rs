@@ -0,0 +1,90 @@
+//! Decaying input with and without denormal flushing: an exponentially decaying tone
+//! runs down into the denormal range and then silence, fed in 512-frame callbacks to a
+//! `Stretch` and a resonant `BiquadFilter`. Reports total and worst-case call time.
+//!
+//! Run with `cargo bench --bench denormals`.
+
+mod common;
+
+use ssstretch::util::buffer::get_channel_slices_mut;
+use ssstretch::{BiquadFilter, Stretch, StretchBuilder};
+use std::array;
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const SECONDS: usize = 10;
+const FRAMES: usize = 512;
+
+/// A 440 Hz tone decaying by ~100 dB per second, so it passes through the
+/// denormal range (~1e-38) after about 8 seconds.
+fn decaying(samples: usize) -> Vec<f32> {
+    let decay = (-100.0f32 / 20.0 * std::f32::consts::LN_10 / SAMPLE_RATE).exp();
+    let mut gain = 1.0f32;
+    (0..samples)
+        .map(|i| {
+            gain *= decay;
+            gain * (i as f32 * 440.0 * std::f32::consts::TAU / SAMPLE_RATE).sin()
+        })
+        .collect()
+}
+
+/// Total and maximum time of each callback.
+fn time_calls<F: FnMut(usize)>(calls: usize, mut f: F) -> (Duration, Duration) {
+    let mut total = Duration::ZERO;
+    let mut max = Duration::ZERO;
+    for call in 0..calls {
+        let start = Instant::now();
+        f(call);
+        let elapsed = start.elapsed();
+        total += elapsed;
+        max = max.max(elapsed);
+    }
+    (total, max)
+}
+
+fn stretch(flush: bool, input: &[f32]) -> (Duration, Duration) {
+    let mut stretch: Stretch<CHANNELS> = StretchBuilder::new()
+        .preset_default(SAMPLE_RATE)
+        .flush_denormals(flush)
+        .build();
+    let mut output = vec![vec![0.0f32; FRAMES]; CHANNELS];
+    time_calls(input.len() / FRAMES, |call| {
+        let chunk = &input[call * FRAMES..(call + 1) * FRAMES];
+        let mut outputs = get_channel_slices_mut::<CHANNELS>(&mut output);
+        stretch.process(array::from_fn(|_| chunk), &mut outputs);
+        black_box(&outputs[0][0]);
+    })
+}
+
+fn biquad(flush: bool, input: &[f32]) -> (Duration, Duration) {
+    let mut filter = BiquadFilter::new();
+    filter.lowpass(0.01, 10.0, None).set_flush_denormals(flush);
+    let mut output = vec![0.0f32; FRAMES];
+    time_calls(input.len() / FRAMES, |call| {
+        filter.process_buffer(&input[call * FRAMES..(call + 1) * FRAMES], &mut output);
+        black_box(&output[0]);
+    })
+}
+
+fn report(name: &str, (total, max): (Duration, Duration)) {
+    println!(
+        "{:>24} {:>10.1}ms {:>10.1}us",
+        name,
+        total.as_secs_f64() * 1e3,
+        max.as_secs_f64() * 1e6,
+    );
+}
+
+fn main() {
+    let input = decaying(SAMPLE_RATE as usize * SECONDS);
+
+    println!("{:>24} {:>12} {:>12}", "variant", "total", "worst call");
+    // Warm up both paths before timing
+    stretch(false, &input[..FRAMES * 8]);
+    report("Stretch", stretch(false, &input));
+    report("Stretch (flushed)", stretch(true, &input));
+    report("BiquadFilter", biquad(false, &input));
+    report("BiquadFilter (flushed)", biquad(true, &input));
+}
@@ -0,0 +1,97 @@
+//! Fixed per-call cost of the processing entry points with tiny (32-frame) callbacks.
+//!
+//! - `block_samples()`: a bare FFI round trip (cxx shim plus a trivial C++ call)
+//! - `process` with zero frames: everything except the DSP
+//! - `process` / `process_vec`: slices, length checks and pointer arrays every call
+//! - `process_planar`: buffers validated once at creation
+//! - `process_unchecked`: pre-built channel pointers, nothing checked
+//!
+//! Run with `cargo bench --bench ffi_overhead`.
+
+mod common;
+
+use ssstretch::util::buffer::{get_channel_slices_mut, PlanarBuffer};
+use ssstretch::{Stretch, StretchBuilder};
+use std::array;
+use std::hint::black_box;
+use std::time::Duration;
+
+const CHANNELS: usize = 2;
+const FRAMES: usize = 32;
+const CALLS: usize = 100_000;
+
+fn build() -> Stretch<CHANNELS> {
+    StretchBuilder::new().preset_cheaper(48_000.0).build()
+}
+
+fn report(name: &str, time: Duration, baseline: Option<Duration>) {
+    let per_call = time.as_secs_f64() * 1e9 / CALLS as f64;
+    match baseline {
+        Some(baseline) => println!(
+            "{:>28} {:>10.1}ns {:>+10.1}ns",
+            name,
+            per_call,
+            per_call - baseline.as_secs_f64() * 1e9 / CALLS as f64
+        ),
+        None => println!("{:>28} {:>10.1}ns", name, per_call),
+    }
+}
+
+fn main() {
+    let mut stretch = build();
+    let input = common::noise(CHANNELS, FRAMES, 9);
+    let mut output = vec![vec![0.0f32; FRAMES]; CHANNELS];
+
+    println!("{:>28} {:>12} {:>12}", "path", "per call", "vs unchecked");
+
+    let time = common::best_of(5, || {
+        for _ in 0..CALLS {
+            black_box(black_box(&stretch).block_samples());
+        }
+    });
+    report("block_samples() (FFI only)", time, None);
+
+    let time = common::best_of(5, || {
+        for _ in 0..CALLS {
+            stretch.process([&[]; CHANNELS], &mut array::from_fn(|_| &mut [][..]));
+        }
+    });
+    report("process, 0 frames", time, None);
+
+    let mut planar_in = PlanarBuffer::<CHANNELS>::new(FRAMES);
+    for (channel, samples) in planar_in.channels_mut().into_iter().enumerate() {
+        samples.copy_from_slice(&input[channel]);
+    }
+    let mut planar_out = PlanarBuffer::<CHANNELS>::new(FRAMES);
+    let input_ptrs: [*const f32; CHANNELS] = array::from_fn(|channel| input[channel].as_ptr());
+    let output_ptrs: [*mut f32; CHANNELS] = array::from_fn(|channel| output[channel].as_mut_ptr());
+
+    // Same stretcher state for every path: reset and warm up before each
+    let run = |stretch: &mut Stretch<CHANNELS>, f: &mut dyn FnMut(&mut Stretch<CHANNELS>)| {
+        common::best_of(5, || {
+            stretch.reset();
+            for _ in 0..CALLS {
+                f(stretch);
+            }
+        })
+    };
+
+    let unchecked = run(&mut stretch, &mut |stretch| unsafe {
+        stretch.process_unchecked(&input_ptrs, FRAMES, &output_ptrs, FRAMES);
+    });
+    let planar = run(&mut stretch, &mut |stretch| {
+        stretch.process_planar(&planar_in, &mut planar_out);
+    });
+    let checked = run(&mut stretch, &mut |stretch| {
+        let mut outputs = get_channel_slices_mut::<CHANNELS>(&mut output);
+        stretch.process(array::from_fn(|channel| &input[channel][..]), &mut outputs);
+    });
+    let vec = run(&mut stretch, &mut |stretch| {
+        stretch.process_vec(&input, FRAMES as i32, &mut output, FRAMES as i32);
+    });
+
+    report("process_unchecked", unchecked, Some(unchecked));
+    report("process_planar", planar, Some(unchecked));
+    report("process", checked, Some(unchecked));
+    report("process_vec", vec, Some(unchecked));
+}
@@ -0,0 +1,101 @@
+//! Throughput of N independent stretchers spread across M threads, to find where a host
+//! stops scaling (cores, memory bandwidth, cache) and how many streams it sustains.
+//!
+//! Every instance is fed 256-frame callbacks at ratio 1. For each grid point this
+//! reports the aggregate realtime factor (seconds of audio per second, over all
+//! streams), per-thread efficiency against a single instance on a single thread, and
+//! the process RSS with all instances alive.
+//!
+//! Run with `cargo bench --bench instance_scaling`.
+
+mod common;
+
+use ssstretch::{Stretch, StretchBuilder};
+use std::array;
+use std::hint::black_box;
+use std::thread;
+use std::time::Instant;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const FRAMES: usize = 256;
+// Audio rendered by each instance
+const SECONDS: usize = 4;
+const INSTANCES_PER_THREAD: [usize; 4] = [1, 2, 4, 8];
+
+/// Run `instances` through `callbacks` callbacks, interleaved as one thread would.
+fn run(instances: &mut [Stretch<CHANNELS>], input: &[Vec<f32>], callbacks: usize) {
+    let mut output = vec![vec![0.0f32; FRAMES]; CHANNELS];
+    for call in 0..callbacks {
+        for (index, stretch) in instances.iter_mut().enumerate() {
+            // Each instance reads its own region so they don't share cache lines
+            let start = (index * 7919 + call * FRAMES) % (input[0].len() - FRAMES);
+            let mut channels = output.iter_mut();
+            let mut outputs: [&mut [f32]; CHANNELS] =
+                array::from_fn(|_| &mut channels.next().unwrap()[..]);
+            stretch.process(
+                array::from_fn(|channel| &input[channel][start..start + FRAMES]),
+                &mut outputs,
+            );
+            black_box(&outputs[0][0]);
+        }
+    }
+}
+
+fn build(count: usize) -> Vec<Stretch<CHANNELS>> {
+    (0..count)
+        .map(|_| StretchBuilder::new().preset_default(SAMPLE_RATE).build())
+        .collect()
+}
+
+/// Aggregate realtime factor of `threads` threads each running `per_thread` instances.
+fn measure(threads: usize, per_thread: usize, input: &[Vec<f32>]) -> (f64, Option<usize>) {
+    let mut groups: Vec<Vec<Stretch<CHANNELS>>> = (0..threads).map(|_| build(per_thread)).collect();
+    // Warm up (and fault in) every instance before timing
+    for group in &mut groups {
+        run(group, input, SAMPLE_RATE as usize / 4 / FRAMES);
+    }
+    let rss = common::rss();
+
+    let start = Instant::now();
+    thread::scope(|scope| {
+        for group in &mut groups {
+            scope.spawn(move || run(group, input, SAMPLE_RATE as usize * SECONDS / FRAMES));
+        }
+    });
+    let elapsed = start.elapsed().as_secs_f64();
+    ((threads * per_thread * SECONDS) as f64 / elapsed, rss)
+}
+
+fn main() {
+    let input = common::noise(CHANNELS, SAMPLE_RATE as usize * 2, 3);
+    let cores = thread::available_parallelism().map_or(1, |n| n.get());
+    let mut thread_counts = vec![1];
+    while thread_counts.last().unwrap() * 2 <= cores * 2 {
+        thread_counts.push(thread_counts.last().unwrap() * 2);
+    }
+
+    let (single, _) = measure(1, 1, &input);
+    println!("{cores} cores; one instance on one thread runs at {single:.1}x realtime");
+    println!(
+        "{:>8} {:>10} {:>10} {:>12} {:>11} {:>12}",
+        "threads", "instances", "streams", "realtime", "efficiency", "rss"
+    );
+    for &threads in &thread_counts {
+        for per_thread in INSTANCES_PER_THREAD {
+            let (realtime, rss) = measure(threads, per_thread, &input);
+            // 100% = every thread (up to the core count) as fast as the single-instance run
+            let efficiency = realtime / (single * threads.min(cores) as f64);
+            println!(
+                "{:>8} {:>10} {:>10} {:>11.1}x {:>10.0}% {:>12}",
+                threads,
+                threads * per_thread,
+                // Realtime streams this configuration sustains
+                realtime.floor() as usize,
+                realtime,
+                100.0 * efficiency,
+                common::mib(rss),
+            );
+        }
+    }
+}
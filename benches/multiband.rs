@@ -0,0 +1,93 @@
+//! Cost of the multiband stretcher against single-band ones: the default preset, and
+//! short blocks across the whole spectrum (the other way to get sharp transients). Then,
+//! at 192 kHz, the default preset against stretching the audible band only. Reports the
+//! time per second of audio for each.
+//!
+//! Run with `cargo bench --bench multiband`.
+
+mod common;
+
+use ssstretch::util::buffer::get_channel_slices_mut;
+use ssstretch::{MultibandStretch, Stretch, StretchBuilder};
+use std::array;
+use std::hint::black_box;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const FRAMES: usize = 512;
+const SECONDS: usize = 4;
+
+/// Seconds taken per second of audio by `process` on `stretch`, after `reset`.
+fn run<S>(
+    input: &[Vec<f32>],
+    stretch: &mut S,
+    reset: fn(&mut S),
+    process: fn(&mut S, [&[f32]; CHANNELS], &mut [&mut [f32]; CHANNELS]),
+) -> f64 {
+    let mut output = vec![vec![0.0f32; FRAMES]; CHANNELS];
+    let calls = input[0].len() / FRAMES;
+    let elapsed = common::best_of(3, || {
+        reset(stretch);
+        for call in 0..calls {
+            let range = call * FRAMES..(call + 1) * FRAMES;
+            let mut outputs = get_channel_slices_mut::<CHANNELS>(&mut output);
+            process(
+                stretch,
+                array::from_fn(|c| &input[c][range.clone()]),
+                &mut outputs,
+            );
+            black_box(&outputs[0][0]);
+        }
+    });
+    elapsed.as_secs_f64() / SECONDS as f64
+}
+
+fn single(input: &[Vec<f32>], mut stretch: Stretch<CHANNELS>) -> f64 {
+    run(
+        input,
+        &mut stretch,
+        Stretch::reset,
+        |stretch, input, output| stretch.process(input, output),
+    )
+}
+
+fn main() {
+    let input = common::noise(CHANNELS, SAMPLE_RATE as usize * SECONDS, 11);
+    let block = |seconds: f32| (seconds * SAMPLE_RATE) as i32;
+
+    let default = single(
+        &input,
+        StretchBuilder::new().preset_default(SAMPLE_RATE).build(),
+    );
+    let short = single(
+        &input,
+        StretchBuilder::new()
+            .configure(block(0.04), block(0.01))
+            .build(),
+    );
+    let mut multiband = MultibandStretch::<CHANNELS>::two_band(SAMPLE_RATE, 500.0);
+    multiband.reserve(FRAMES, FRAMES);
+    let split = run(
+        &input,
+        &mut multiband,
+        MultibandStretch::reset,
+        |stretch, input, output| stretch.process(input, output),
+    );
+
+    println!("{:<28} {:>10}", "stretcher", "ms per s");
+    println!("{:<28} {:>10.2}", "default preset", default * 1e3);
+    println!("{:<28} {:>10.2}", "short blocks (40 ms)", short * 1e3);
+    println!("{:<28} {:>10.2}", "two bands at 500 Hz", split * 1e3);
+
+    // A 192 kHz session, in full and through the audible band only
+    let high_rate = 192_000.0;
+    let input = common::noise(CHANNELS, high_rate as usize * SECONDS, 12);
+    let full = single(&input, StretchBuilder::new().preset_default(high_rate).build());
+    let mut audible = MultibandStretch::<CHANNELS>::high_rate(high_rate);
+    audible.reserve(FRAMES, FRAMES);
+    let audible = run(&input, &mut audible, MultibandStretch::reset, |stretch, input, output| {
+        stretch.process(input, output)
+    });
+    println!("{:<28} {:>10.2}", "192 kHz, default preset", full * 1e3);
+    println!("{:<28} {:>10.2}", "192 kHz, audible band", audible * 1e3);
+}
@@ -0,0 +1,102 @@
+//! Speed-up of `ParallelRender` over a single stretcher on one long input.
+//!
+//! Renders a minute of stereo noise at ratio 1.25 with one instance, then with
+//! `ParallelRender` on 1, 2, 4, ... threads, reporting the realtime factor, speed-up,
+//! and how far the result deviates from the single-instance render (segment
+//! boundaries are crossfades between two independent renders, so it isn't identical).
+//!
+//! Run with `cargo bench --bench parallel_render`.
+
+mod common;
+
+use ssstretch::{ParallelRender, Stretch, StretchBuilder};
+use std::array;
+use std::thread;
+use std::time::Instant;
+
+const CHANNELS: usize = 2;
+const SAMPLE_RATE: f32 = 48_000.0;
+const SECONDS: usize = 60;
+const RATIO: f64 = 1.25;
+
+fn make() -> Stretch<CHANNELS> {
+    StretchBuilder::new().preset_default(SAMPLE_RATE).build()
+}
+
+/// The whole input through one stretcher, in the same alignment as `ParallelRender`.
+fn single(input: &[Vec<f32>]) -> Vec<Vec<f32>> {
+    let mut stretch = make();
+    let length = input[0].len();
+    let input_latency = stretch.input_latency() as usize;
+    let output_latency = stretch.output_latency() as usize;
+    let out_length = (length as f64 * RATIO).round() as usize;
+    let mut output = vec![vec![0.0f32; out_length + output_latency]; CHANNELS];
+
+    stretch.seek(array::from_fn(|c| &input[c][..input_latency]), 1.0 / RATIO);
+    let padded: Vec<Vec<f32>> = input
+        .iter()
+        .map(|channel| {
+            let mut samples = channel[input_latency..].to_vec();
+            samples.resize(length, 0.0);
+            samples
+        })
+        .collect();
+    {
+        let mut channels = output.iter_mut();
+        let mut outputs: [&mut [f32]; CHANNELS] =
+            array::from_fn(|_| &mut channels.next().unwrap()[..out_length]);
+        stretch.process(array::from_fn(|c| &padded[c][..]), &mut outputs);
+    }
+    let mut channels = output.iter_mut();
+    stretch.flush(array::from_fn(|_| &mut channels.next().unwrap()[out_length..]));
+    for channel in &mut output {
+        channel.truncate(out_length);
+    }
+    output
+}
+
+/// Error of `rendered` relative to `reference`, in dB.
+fn difference_db(rendered: &[Vec<f32>], reference: &[Vec<f32>]) -> f64 {
+    let (mut error, mut energy) = (0.0f64, 0.0f64);
+    for (a, b) in rendered.iter().zip(reference) {
+        for (x, y) in a.iter().zip(b) {
+            error += ((x - y) as f64).powi(2);
+            energy += (*y as f64).powi(2);
+        }
+    }
+    10.0 * (error / energy.max(f64::MIN_POSITIVE)).log10()
+}
+
+fn main() {
+    let input = common::noise(CHANNELS, SAMPLE_RATE as usize * SECONDS, 5);
+    let cores = thread::available_parallelism().map_or(1, |n| n.get());
+
+    let start = Instant::now();
+    let reference = single(&input);
+    let baseline = start.elapsed().as_secs_f64();
+    println!(
+        "{cores} cores; one instance renders {SECONDS}s at {:.1}x realtime",
+        SECONDS as f64 / baseline
+    );
+    println!(
+        "{:>8} {:>10} {:>10} {:>12}",
+        "threads", "realtime", "speed-up", "difference"
+    );
+
+    let mut threads = 1;
+    while threads <= cores {
+        let start = Instant::now();
+        let output = ParallelRender::new(SAMPLE_RATE)
+            .threads(threads)
+            .render([&input[0][..], &input[1][..]], RATIO, make);
+        let elapsed = start.elapsed().as_secs_f64();
+        println!(
+            "{:>8} {:>9.1}x {:>9.2}x {:>9.1} dB",
+            threads,
+            SECONDS as f64 / elapsed,
+            baseline / elapsed,
+            difference_db(&output, &reference),
+        );
+        threads *= 2;
+    }
+}
@@ -0,0 +1,400 @@
+//! Quality against CPU cost for the presets and a grid of `configure()` settings.
+//!
+//! A small corpus is generated locally, together with an ideal stretched version of
+//! each item (the same parametric signal rendered with its timing scaled):
+//! - tones: a steady harmonic tone
+//! - transients: short decaying noise clicks
+//! - speech: noise bursts with a syllable-rate envelope through a moving formant filter
+//!
+//! Each configuration stretches the corpus at a few ratios and is scored on:
+//! - spectral convergence: `||A - B|| / ||B||` over log-spaced band magnitudes of the
+//!   output (A) and the ideal (B), after aligning them; lower is better
+//! - transient smearing: how much wider (ms) each click's 10-90% energy span is than in
+//!   the ideal render
+//! - phasiness proxy: extra short-term level fluctuation on the steady tone, in percent
+//!   (phasey stretching shows up as a warbling envelope)
+//!
+//! Configurations no other one beats on cost and all three metrics are marked `*`.
+//!
+//! Run with `cargo bench --bench quality_cost`.
+
+mod common;
+
+use common::Rng;
+use ssstretch::dsp::filters::BiquadFilter;
+use ssstretch::{Stretch, StretchBuilder};
+use std::f64::consts::PI;
+use std::time::{Duration, Instant};
+
+const SAMPLE_RATE: f32 = 48_000.0;
+const SECONDS: f32 = 6.0;
+const RATIOS: [f32; 3] = [0.8, 1.25, 2.0];
+const CALLBACK: usize = 512;
+
+const FRAME: usize = 2048;
+const HOP: usize = 512;
+const BANDS: usize = 24;
+// 1 ms envelope resolution for alignment
+const ENVELOPE_HOP: usize = 48;
+const MAX_LAG_MS: usize = 250;
+
+const CLICK_PERIOD: f32 = 0.25;
+const CLICK_DECAY: f32 = 0.005;
+
+struct Corpus {
+    tones: Vec<f32>,
+    transients: Vec<f32>,
+    speech: Vec<f32>,
+}
+
+impl Corpus {
+    /// The corpus with all timing scaled by `scale` (1.0 for the input itself).
+    fn render(scale: f32) -> Self {
+        let samples = (SAMPLE_RATE * SECONDS * scale) as usize;
+        Self {
+            tones: tones(samples),
+            transients: transients(samples, scale),
+            speech: speech(samples, scale),
+        }
+    }
+
+    fn items(&self) -> [&[f32]; 3] {
+        [&self.tones, &self.transients, &self.speech]
+    }
+}
+
+fn tones(samples: usize) -> Vec<f32> {
+    (0..samples)
+        .map(|i| {
+            let t = i as f64 / SAMPLE_RATE as f64;
+            (1..=6)
+                .map(|k| (2.0 * PI * 220.0 * k as f64 * t).sin() / k as f64)
+                .sum::<f64>() as f32
+                * 0.3
+        })
+        .collect()
+}
+
+fn click_onsets(samples: usize, scale: f32) -> impl Iterator<Item = usize> {
+    let period = (CLICK_PERIOD * scale * SAMPLE_RATE) as usize;
+    (period / 2..samples).step_by(period)
+}
+
+fn transients(samples: usize, scale: f32) -> Vec<f32> {
+    let mut signal = vec![0.0; samples];
+    let length = (CLICK_DECAY * 10.0 * SAMPLE_RATE) as usize;
+    for (click, onset) in click_onsets(samples, scale).enumerate() {
+        // Same noise for a click in the input and the ideal render
+        let mut rng = Rng::new(click as u32 + 1);
+        for (i, sample) in signal[onset..].iter_mut().take(length).enumerate() {
+            *sample = rng.signed() * (-(i as f32) / (CLICK_DECAY * SAMPLE_RATE)).exp();
+        }
+    }
+    signal
+}
+
+fn speech(samples: usize, scale: f32) -> Vec<f32> {
+    let mut signal = vec![0.0; samples];
+    let syllable = (0.2 * scale * SAMPLE_RATE) as usize;
+    let voiced = syllable * 3 / 4;
+    let mut formants = Rng::new(3);
+    let mut rng = Rng::new(4);
+    for start in (0..samples).step_by(syllable) {
+        let formant = formants.range(300, 2500) as f32;
+        let mut filter = BiquadFilter::new();
+        filter.bandpass(formant / SAMPLE_RATE, 1.0, None);
+        let end = (start + voiced).min(samples);
+        let excitation: Vec<f32> = (start..end).map(|_| rng.signed()).collect();
+        filter.process_buffer(&excitation, &mut signal[start..end]);
+        for (i, sample) in signal[start..end].iter_mut().enumerate() {
+            *sample *= (PI * i as f64 / voiced as f64).sin().powi(2) as f32;
+        }
+    }
+    signal
+}
+
+struct Config {
+    name: String,
+    build: Box<dyn Fn() -> Stretch<1>>,
+}
+
+fn configs() -> Vec<Config> {
+    let mut configs = vec![
+        Config {
+            name: "default".into(),
+            build: Box::new(|| StretchBuilder::new().preset_default(SAMPLE_RATE).build()),
+        },
+        Config {
+            name: "cheaper".into(),
+            build: Box::new(|| StretchBuilder::new().preset_cheaper(SAMPLE_RATE).build()),
+        },
+    ];
+    for block in [2048, 3072, 4096, 6144] {
+        for overlap in [4, 6] {
+            let interval = block / overlap;
+            configs.push(Config {
+                name: format!("{block}/{interval}"),
+                build: Box::new(move || StretchBuilder::new().configure(block, interval).build()),
+            });
+        }
+    }
+    configs
+}
+
+/// Stretch `input` by `ratio` in callback-sized chunks, including the flushed tail.
+fn stretch(stretch: &mut Stretch<1>, input: &[f32], ratio: f32) -> (Vec<f32>, Duration) {
+    stretch.reset();
+    let out_samples = (input.len() as f32 * ratio) as usize;
+    let mut output = vec![0.0; out_samples + stretch.output_latency() as usize];
+
+    let start = Instant::now();
+    let mut consumed = 0;
+    for (chunk, frames) in output[..out_samples].chunks_mut(CALLBACK).enumerate() {
+        let end = (((chunk * CALLBACK + frames.len()) as f32 / ratio) as usize).min(input.len());
+        stretch.process([&input[consumed..end]], &mut [frames]);
+        consumed = end;
+    }
+    stretch.flush([&mut output[out_samples..]]);
+    (output, start.elapsed())
+}
+
+fn envelope(signal: &[f32], hop: usize) -> Vec<f32> {
+    signal
+        .chunks(hop)
+        .map(|chunk| (chunk.iter().map(|x| x * x).sum::<f32>() / chunk.len() as f32).sqrt())
+        .collect()
+}
+
+/// Drop the output's leading latency so it lines up with the ideal render, using the
+/// lag that best correlates their 1 ms envelopes.
+fn align<'a>(output: &'a [f32], ideal: &[f32]) -> &'a [f32] {
+    let out_env = envelope(output, ENVELOPE_HOP);
+    let ideal_env = envelope(ideal, ENVELOPE_HOP);
+    let best_lag = (0..=MAX_LAG_MS)
+        .map(|lag| {
+            let score: f32 = ideal_env
+                .iter()
+                .zip(out_env.iter().skip(lag))
+                .map(|(a, b)| a * b)
+                .sum();
+            (lag, score)
+        })
+        .max_by(|a, b| a.1.total_cmp(&b.1))
+        .map_or(0, |(lag, _)| lag);
+    &output[(best_lag * ENVELOPE_HOP).min(output.len())..]
+}
+
+/// Radix-2 complex FFT with a precomputed twiddle table.
+struct Fft {
+    twiddles: Vec<(f32, f32)>,
+}
+
+impl Fft {
+    fn new(size: usize) -> Self {
+        let twiddles = (0..size / 2)
+            .map(|k| {
+                let (sin, cos) = (-2.0 * PI * k as f64 / size as f64).sin_cos();
+                (cos as f32, sin as f32)
+            })
+            .collect();
+        Self { twiddles }
+    }
+
+    fn forward(&self, re: &mut [f32], im: &mut [f32]) {
+        let size = re.len();
+        let mut j = 0;
+        for i in 1..size {
+            let mut bit = size >> 1;
+            while j & bit != 0 {
+                j ^= bit;
+                bit >>= 1;
+            }
+            j |= bit;
+            if i < j {
+                re.swap(i, j);
+                im.swap(i, j);
+            }
+        }
+        let mut length = 2;
+        while length <= size {
+            let stride = size / length;
+            for start in (0..size).step_by(length) {
+                for k in 0..length / 2 {
+                    let (cos, sin) = self.twiddles[k * stride];
+                    let (a, b) = (start + k, start + k + length / 2);
+                    let (tr, ti) = (re[b] * cos - im[b] * sin, re[b] * sin + im[b] * cos);
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+            length <<= 1;
+        }
+    }
+}
+
+/// Band magnitudes (log-spaced, 50 Hz to 16 kHz) of Hann-windowed frames.
+fn band_spectrogram(fft: &Fft, signal: &[f32]) -> Vec<[f32; BANDS]> {
+    let window: Vec<f32> = (0..FRAME)
+        .map(|i| (PI * i as f64 / FRAME as f64).sin().powi(2) as f32)
+        .collect();
+    let bin_hz = SAMPLE_RATE / FRAME as f32;
+    let edges: Vec<usize> = (0..=BANDS)
+        .map(|band| (50.0 * (16_000.0f32 / 50.0).powf(band as f32 / BANDS as f32) / bin_hz) as usize)
+        .collect();
+
+    let mut re = vec![0.0; FRAME];
+    let mut im = vec![0.0; FRAME];
+    signal
+        .windows(FRAME)
+        .step_by(HOP)
+        .map(|frame| {
+            for i in 0..FRAME {
+                re[i] = frame[i] * window[i];
+                im[i] = 0.0;
+            }
+            fft.forward(&mut re, &mut im);
+            std::array::from_fn(|band| {
+                (edges[band]..edges[band + 1].max(edges[band] + 1))
+                    .map(|bin| re[bin] * re[bin] + im[bin] * im[bin])
+                    .sum::<f32>()
+                    .sqrt()
+            })
+        })
+        .collect()
+}
+
+fn spectral_convergence(fft: &Fft, output: &[f32], ideal: &[f32]) -> f32 {
+    let length = output.len().min(ideal.len());
+    let output = band_spectrogram(fft, &output[..length]);
+    let ideal = band_spectrogram(fft, &ideal[..length]);
+    let (mut error, mut reference) = (0.0, 0.0);
+    for (a, b) in output.iter().flatten().zip(ideal.iter().flatten()) {
+        error += (a - b) * (a - b);
+        reference += b * b;
+    }
+    (error / reference).sqrt()
+}
+
+/// Mean width in ms of the span holding 10-90% of each click's energy.
+fn click_width(signal: &[f32], scale: f32) -> f32 {
+    let half = (0.05 * SAMPLE_RATE) as usize;
+    let widths: Vec<f32> = click_onsets(signal.len(), scale)
+        .filter(|&onset| onset >= half && onset + half <= signal.len())
+        .map(|onset| {
+            let window = &signal[onset - half..onset + half];
+            let total: f32 = window.iter().map(|x| x * x).sum();
+            let mut energy = 0.0;
+            let (mut low, mut high) = (0, window.len());
+            for (i, x) in window.iter().enumerate() {
+                energy += x * x;
+                if energy < 0.1 * total {
+                    low = i;
+                }
+                if energy < 0.9 * total {
+                    high = i;
+                }
+            }
+            (high - low) as f32 / SAMPLE_RATE * 1000.0
+        })
+        .collect();
+    widths.iter().sum::<f32>() / widths.len().max(1) as f32
+}
+
+/// Coefficient of variation (%) of the 10 ms level, away from the edges.
+fn level_fluctuation(signal: &[f32]) -> f32 {
+    let edge = (0.5 * SAMPLE_RATE) as usize;
+    let levels = envelope(&signal[edge..signal.len().saturating_sub(edge).max(edge)], 480);
+    let mean = levels.iter().sum::<f32>() / levels.len() as f32;
+    let variance = levels.iter().map(|l| (l - mean) * (l - mean)).sum::<f32>() / levels.len() as f32;
+    100.0 * variance.sqrt() / mean
+}
+
+struct Score {
+    name: String,
+    block: i32,
+    interval: i32,
+    realtime: f64,
+    convergence: f32,
+    smearing: f32,
+    phasiness: f32,
+}
+
+impl Score {
+    fn dominated_by(&self, other: &Score) -> bool {
+        other.realtime >= self.realtime
+            && other.convergence <= self.convergence
+            && other.smearing <= self.smearing
+            && other.phasiness <= self.phasiness
+            && (other.realtime > self.realtime
+                || other.convergence < self.convergence
+                || other.smearing < self.smearing
+                || other.phasiness < self.phasiness)
+    }
+}
+
+fn main() {
+    let input = Corpus::render(1.0);
+    let ideals: Vec<Corpus> = RATIOS.iter().map(|&ratio| Corpus::render(ratio)).collect();
+    let fft = Fft::new(FRAME);
+
+    let mut scores = Vec::new();
+    for config in configs() {
+        let mut stretcher = (config.build)();
+        let mut time = Duration::ZERO;
+        let mut audio = 0.0;
+        let (mut convergence, mut smearing, mut phasiness) = (0.0, 0.0, 0.0);
+        for (&ratio, ideal) in RATIOS.iter().zip(&ideals) {
+            let [tones, transients, speech] = input.items().map(|item| {
+                let (output, elapsed) = stretch(&mut stretcher, item, ratio);
+                time += elapsed;
+                audio += item.len() as f64 * ratio as f64 / SAMPLE_RATE as f64;
+                output
+            });
+
+            let tones = align(&tones, &ideal.tones);
+            let transients = align(&transients, &ideal.transients);
+            let speech = align(&speech, &ideal.speech);
+            convergence += (spectral_convergence(&fft, tones, &ideal.tones)
+                + spectral_convergence(&fft, transients, &ideal.transients)
+                + spectral_convergence(&fft, speech, &ideal.speech))
+                / 3.0;
+            smearing += click_width(transients, ratio) - click_width(&ideal.transients, ratio);
+            phasiness += level_fluctuation(tones) - level_fluctuation(&ideal.tones);
+        }
+        let runs = RATIOS.len() as f32;
+        scores.push(Score {
+            name: config.name,
+            block: stretcher.block_samples(),
+            interval: stretcher.interval_samples(),
+            realtime: audio / time.as_secs_f64(),
+            convergence: convergence / runs,
+            smearing: smearing / runs,
+            phasiness: phasiness / runs,
+        });
+    }
+
+    println!(
+        "ratios {:?}, {} s corpus; lower convergence/smearing/phasiness is better",
+        RATIOS, SECONDS
+    );
+    println!(
+        "  {:>10} {:>6} {:>8} {:>10} {:>12} {:>11} {:>10}",
+        "config", "block", "interval", "realtime", "convergence", "smear ms", "phasiness"
+    );
+    for score in &scores {
+        let optimal = !scores.iter().any(|other| score.dominated_by(other));
+        println!(
+            "{} {:>10} {:>6} {:>8} {:>9.1}x {:>12.3} {:>11.2} {:>9.2}%",
+            if optimal { "*" } else { " " },
+            score.name,
+            score.block,
+            score.interval,
+            score.realtime,
+            score.convergence,
+            score.smearing,
+            score.phasiness,
+        );
+    }
+}
@@ -5,14 +5,37 @@ fn main() {
     println!("HOST = {:?}", std::env::var("HOST"));
     
     // Build the C++ code
-    cxx_build::bridge("src/ffi.rs")
+    let mut build = cxx_build::bridge("src/ffi.rs");
+    build
+        .file("src/bridge.cc")
         .include("src")
         .include("src/signalsmith-stretch")
-        .flag_if_supported("-std=c++14")
-        .compile("ssstretch");
+        .flag_if_supported("-std=c++14");
+
+    // Route C++ allocations to a Rust allocator (replaces the process-wide operator new)
+    if std::env::var_os("CARGO_FEATURE_CUSTOM_ALLOCATOR").is_some() {
+        build.define("SSSTRETCH_CUSTOM_ALLOCATOR", None);
+    }
+
+    // Add processing entry points for wider instruction sets and pick one at runtime
+    // (x86 with GCC/Clang only; see dispatch_isa.cc)
+    let target_arch = std::env::var("CARGO_CFG_TARGET_ARCH").unwrap_or_default();
+    let cpu_dispatch = std::env::var_os("CARGO_FEATURE_CPU_DISPATCH").is_some()
+        && (target_arch == "x86_64" || target_arch == "x86")
+        && !build.get_compiler().is_like_msvc();
+    if cpu_dispatch {
+        build
+            .file("src/dispatch_isa.cc")
+            .define("SSSTRETCH_CPU_DISPATCH", None);
+    }
+
+    build.compile("ssstretch");
 
     // Tell cargo to re-run this build script if source files change
     println!("cargo:rerun-if-changed=src/bridge.h");
+    println!("cargo:rerun-if-changed=src/bridge.cc");
+    println!("cargo:rerun-if-changed=src/dispatch.h");
+    println!("cargo:rerun-if-changed=src/dispatch_isa.cc");
     println!("cargo:rerun-if-changed=src/ffi.rs");
     println!("cargo:rerun-if-changed=src/lib.rs");
     println!("cargo:rerun-if-changed=src/stretch.rs");
@@ -0,0 +1,163 @@
+#[cfg(feature = "custom-allocator")]
+use crate::ffi;
+use std::alloc::{GlobalAlloc, Layout};
+#[cfg(feature = "custom-allocator")]
+use std::cell::RefCell;
+use std::sync::atomic::{AtomicUsize, Ordering};
+#[cfg(feature = "custom-allocator")]
+use std::sync::Arc;
+
+/// Allocator receiving the C++ heap allocations made by a stretcher.
+///
+/// Wraps any `GlobalAlloc` (an arena, bump or pool allocator, huge pages, ...) and counts
+/// the bytes and allocations it currently holds, so memory can be attributed to whoever
+/// owns the allocator. Clones share the same allocator and counters.
+///
+/// Requires the `custom-allocator` feature. The feature replaces the global C++
+/// `operator new` and `operator delete` for the whole process, not just this crate: every
+/// C++ allocation in the binary, including other C++ libraries linked into it, goes through
+/// the replacement and carries a 16-byte header. Only allocations made on a thread while
+/// it constructs or configures a stretcher that has an allocator are routed here.
+/// Everything else falls through to `malloc`. Leave the feature off if another library in
+/// the binary defines its own global `operator new`.
+#[cfg(feature = "custom-allocator")]
+#[derive(Clone)]
+pub struct StretchAllocator {
+    handle: Arc<AllocatorHandle>,
+}
+
+#[cfg(feature = "custom-allocator")]
+impl StretchAllocator {
+    /// Route stretcher allocations to `alloc`.
+    pub fn new<A: GlobalAlloc + Send + Sync + 'static>(alloc: A) -> Self {
+        Self {
+            handle: Arc::new(AllocatorHandle {
+                alloc: Box::new(alloc),
+                bytes: AtomicUsize::new(0),
+                allocations: AtomicUsize::new(0),
+            }),
+        }
+    }
+
+    /// Bytes currently allocated through this allocator (including per-block headers).
+    pub fn allocated_bytes(&self) -> usize {
+        self.handle.bytes.load(Ordering::Relaxed)
+    }
+
+    /// Number of live allocations made through this allocator.
+    pub fn allocation_count(&self) -> usize {
+        self.handle.allocations.load(Ordering::Relaxed)
+    }
+}
+
+/// Cumulative C++ heap activity in this process, counted by the replaced `operator new`.
+///
+/// Includes every C++ allocation (stretchers, filters, and other C++ code linked into
+/// the binary), whether or not it was routed to a `StretchAllocator`. Take the
+/// difference of two readings to count the allocations made by an operation.
+#[cfg(feature = "custom-allocator")]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CxxAllocations {
+    /// Allocations made so far.
+    pub count: u64,
+    /// Bytes requested by those allocations.
+    pub bytes: u64,
+}
+
+#[cfg(feature = "custom-allocator")]
+impl CxxAllocations {
+    /// Current totals.
+    pub fn now() -> Self {
+        Self {
+            count: ffi::cxx_allocation_count(),
+            bytes: ffi::cxx_allocated_bytes(),
+        }
+    }
+
+    /// Allocations made since `earlier`.
+    pub fn since(&self, earlier: &Self) -> Self {
+        Self {
+            count: self.count - earlier.count,
+            bytes: self.bytes - earlier.bytes,
+        }
+    }
+}
+
+/// Opaque state shared with the C++ side, which records it in every block it allocates.
+pub struct AllocatorHandle {
+    alloc: Box<dyn GlobalAlloc + Send + Sync>,
+    bytes: AtomicUsize,
+    allocations: AtomicUsize,
+}
+
+#[cfg(feature = "custom-allocator")]
+thread_local! {
+    // Allocator the C++ side is routing this thread's allocations to, if any
+    static ROUTED: RefCell<Option<Arc<AllocatorHandle>>> = const { RefCell::new(None) };
+}
+
+/// Routes C++ allocations made on this thread to an allocator until dropped, then
+/// restores whatever routing was in place when it was entered, so scopes can nest.
+///
+/// Entering with `None` does nothing, so the default path makes no extra FFI calls.
+#[cfg(feature = "custom-allocator")]
+pub(crate) struct AllocatorScope {
+    // Routing to restore on drop, or `None` if this scope didn't change it
+    previous: Option<Option<Arc<AllocatorHandle>>>,
+}
+
+#[cfg(feature = "custom-allocator")]
+impl AllocatorScope {
+    pub(crate) fn enter(allocator: Option<&StretchAllocator>) -> Self {
+        let previous = allocator.map(|allocator| {
+            ffi::set_stretch_allocator(&allocator.handle);
+            ROUTED.with(|routed| routed.replace(Some(Arc::clone(&allocator.handle))))
+        });
+        Self { previous }
+    }
+}
+
+#[cfg(feature = "custom-allocator")]
+impl Drop for AllocatorScope {
+    fn drop(&mut self) {
+        if let Some(previous) = self.previous.take() {
+            match &previous {
+                Some(handle) => ffi::set_stretch_allocator(handle),
+                None => ffi::clear_stretch_allocator(),
+            }
+            ROUTED.with(|routed| routed.replace(previous));
+        }
+    }
+}
+
+// Called from the C++ `operator new` replacement in bridge.cc
+pub(crate) unsafe fn stretch_allocator_allocate(
+    handle: &AllocatorHandle,
+    size: usize,
+    align: usize,
+) -> *mut u8 {
+    let layout = match Layout::from_size_align(size, align) {
+        Ok(layout) => layout,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let ptr = handle.alloc.alloc(layout);
+    if !ptr.is_null() {
+        handle.bytes.fetch_add(size, Ordering::Relaxed);
+        handle.allocations.fetch_add(1, Ordering::Relaxed);
+    }
+    ptr
+}
+
+// Called from the C++ `operator delete` replacement in bridge.cc
+pub(crate) unsafe fn stretch_allocator_deallocate(
+    handle: &AllocatorHandle,
+    ptr: *mut u8,
+    size: usize,
+    align: usize,
+) {
+    handle
+        .alloc
+        .dealloc(ptr, Layout::from_size_align_unchecked(size, align));
+    handle.bytes.fetch_sub(size, Ordering::Relaxed);
+    handle.allocations.fetch_sub(1, Ordering::Relaxed);
+}
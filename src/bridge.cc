@@ -0,0 +1,160 @@
+#include "ssstretch/src/ffi.rs.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocator routing
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+    // Allocator for C++ allocations made on this thread, set by AllocatorScope in allocator.rs
+    thread_local const AllocatorHandle *currentAllocator = nullptr;
+
+    // Every allocation through the replaced operator new, routed or not
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+}
+
+void set_stretch_allocator(const AllocatorHandle &allocator) {
+    currentAllocator = &allocator;
+}
+
+void clear_stretch_allocator() {
+    currentAllocator = nullptr;
+}
+
+uint64_t cxx_allocation_count() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t cxx_allocated_bytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+#ifdef SSSTRETCH_CUSTOM_ALLOCATOR
+namespace {
+    // Every block records which allocator owns it, so it can be freed on any thread
+    // and after the scope which allocated it has ended.
+    struct AllocationHeader {
+        const AllocatorHandle *allocator;
+        size_t size;
+    };
+    constexpr size_t blockAlign = alignof(std::max_align_t);
+    constexpr size_t headerSize = (sizeof(AllocationHeader) + blockAlign - 1)/blockAlign*blockAlign;
+
+    void * allocate(size_t size) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        size_t total = size + headerSize;
+        void *block;
+        if (currentAllocator) {
+            block = stretch_allocator_allocate(*currentAllocator, total, blockAlign);
+        } else {
+            block = std::malloc(total);
+        }
+        if (!block) throw std::bad_alloc();
+
+        auto *header = static_cast<AllocationHeader *>(block);
+        header->allocator = currentAllocator;
+        header->size = total;
+        return static_cast<char *>(block) + headerSize;
+    }
+
+    void deallocate(void *ptr) noexcept {
+        if (!ptr) return;
+        auto *block = static_cast<char *>(ptr) - headerSize;
+        auto *header = reinterpret_cast<AllocationHeader *>(block);
+        if (header->allocator) {
+            stretch_allocator_deallocate(*header->allocator, reinterpret_cast<uint8_t *>(block), header->size, blockAlign);
+        } else {
+            std::free(block);
+        }
+    }
+}
+
+// Replacements for the global operators. The nothrow variants call these by default,
+// and over-aligned allocations keep using the standard library's implementation.
+void * operator new(size_t size) {
+    return allocate(size);
+}
+
+void * operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    deallocate(ptr);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Runtime CPU dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+    // Best instruction set this build can use on this CPU
+    int detectStretchIsa() {
+#if defined(SSSTRETCH_CPU_DISPATCH)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+            return stretchIsaAvx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return stretchIsaAvx2;
+        }
+#endif
+        return stretchIsaBaseline;
+    }
+
+    // -1 until first use, then the selected StretchIsa
+    std::atomic<int> selectedIsa{-1};
+}
+
+int32_t stretch_supported_isa() {
+    static const int supported = detectStretchIsa();
+    return supported;
+}
+
+int32_t stretch_active_isa() {
+    int isa = selectedIsa.load(std::memory_order_relaxed);
+    if (isa < 0) {
+        // Keep a selection made concurrently by stretch_select_isa()
+        int detected = stretch_supported_isa();
+        if (selectedIsa.compare_exchange_strong(isa, detected, std::memory_order_relaxed)) {
+            isa = detected;
+        }
+    }
+    return isa;
+}
+
+bool stretch_select_isa(int32_t isa) {
+    if (isa < stretchIsaBaseline || isa > stretch_supported_isa()) return false;
+    selectedIsa.store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+#if defined(SSSTRETCH_CPU_DISPATCH)
+const StretchKernels * activeStretchKernels() {
+    switch (stretch_active_isa()) {
+        case stretchIsaAvx512: return &stretchKernelsAvx512;
+        case stretchIsaAvx2: return &stretchKernelsAvx2;
+        default: return nullptr;
+    }
+}
+#endif
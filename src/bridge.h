@@ -2,6 +2,8 @@
 
 #include "./signalsmith-stretch/signalsmith-stretch.h"
 #include "./signalsmith-stretch/dsp/filters.h"
+#include "./dispatch.h"
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <utility>
@@ -22,10 +24,39 @@ namespace std {
 
 // Time stretch
 using SignalsmithStretchFloat = signalsmith::stretch::SignalsmithStretch<float>;
+using SignalsmithStretchDouble = signalsmith::stretch::SignalsmithStretch<double>;
 
 // DSP - Filters
 using BiquadStaticFloat = signalsmith::filters::BiquadStatic<float>;
 
+///////////////////////////////////////////////////////////////////////////////
+// Allocator routing (defined in bridge.cc)
+///////////////////////////////////////////////////////////////////////////////
+
+// Opaque Rust type, see allocator.rs
+struct AllocatorHandle;
+
+// While set, `operator new` on this thread allocates from the given Rust allocator.
+// Only takes effect when built with the `custom-allocator` feature.
+void set_stretch_allocator(const AllocatorHandle &allocator);
+void clear_stretch_allocator();
+// Cumulative allocations (and bytes) made through the replaced `operator new`, which
+// covers all C++ code in the process; always 0 without the `custom-allocator` feature.
+uint64_t cxx_allocation_count();
+uint64_t cxx_allocated_bytes();
+
+///////////////////////////////////////////////////////////////////////////////
+// Runtime CPU dispatch (defined in bridge.cc)
+///////////////////////////////////////////////////////////////////////////////
+
+// Instruction set used by process/seek/flush, as a StretchIsa value. Without the
+// `cpu-dispatch` feature this is always the baseline.
+int32_t stretch_active_isa();
+// Best instruction set this build can run on this CPU
+int32_t stretch_supported_isa();
+// Switch to another instruction set, if this build and CPU support it
+bool stretch_select_isa(int32_t isa);
+
 ///////////////////////////////////////////////////////////////////////////////
 // TimStretch API
 ///////////////////////////////////////////////////////////////////////////////
@@ -46,6 +77,10 @@ inline int outputLatency(const SignalsmithStretchFloat& stretch) {
     return stretch.outputLatency();
 }
 
+inline size_t signalsmith_stretch_object_size() {
+    return sizeof(SignalsmithStretchFloat);
+}
+
 // Factory functions
 inline std::unique_ptr<SignalsmithStretchFloat> new_signalsmith_stretch() {
     return std::make_unique<SignalsmithStretchFloat>();
@@ -57,61 +92,173 @@ inline std::unique_ptr<SignalsmithStretchFloat> new_signalsmith_stretch_with_see
 }
 
 // Helper for handling buffer views
-class FloatBufferView {
+template<typename Sample>
+class BufferView {
 private:
-    const float* const* buffers;
+    const Sample* const* buffers;
 
 public:
-    FloatBufferView(const float* const* bufs, int /* channels */) : buffers(bufs) {}
+    BufferView(const Sample* const* bufs, int /* channels */) : buffers(bufs) {}
     
-    const float* operator[](size_t channel) const {
+    const Sample* operator[](size_t channel) const {
         return buffers[channel];
     }
 };
 
-class FloatBufferMutView {
+template<typename Sample>
+class BufferMutView {
 private:
-    float* const* buffers;
+    Sample* const* buffers;
 
 public:
-    FloatBufferMutView(float* const* bufs, int /* channels */) : buffers(bufs) {}
+    BufferMutView(Sample* const* bufs, int /* channels */) : buffers(bufs) {}
     
-    float* operator[](size_t channel) const {
+    Sample* operator[](size_t channel) const {
         return buffers[channel];
     }
 };
 
+using FloatBufferView = BufferView<float>;
+using FloatBufferMutView = BufferMutView<float>;
+
 // Process wrapper for handling the templated process method
+template<typename Sample>
+inline void stretchProcess(
+    signalsmith::stretch::SignalsmithStretch<Sample>& stretch,
+    const Sample* const* inputs, int inputSamples,
+    Sample** outputs, int outputSamples,
+    int channels
+) {
+    BufferView<Sample> inputView(inputs, channels);
+    BufferMutView<Sample> outputView(outputs, channels);
+    stretch.process(inputView, inputSamples, outputView, outputSamples);
+}
+
+// Seek wrapper
+template<typename Sample>
+inline void stretchSeek(
+    signalsmith::stretch::SignalsmithStretch<Sample>& stretch,
+    const Sample* const* inputs, int inputSamples,
+    double playbackRate,
+    int channels
+) {
+    BufferView<Sample> inputView(inputs, channels);
+    stretch.seek(inputView, inputSamples, playbackRate);
+}
+
+// Flush wrapper
+template<typename Sample>
+inline void stretchFlush(
+    signalsmith::stretch::SignalsmithStretch<Sample>& stretch,
+    Sample** outputs, int outputSamples,
+    int channels
+) {
+    BufferMutView<Sample> outputView(outputs, channels);
+    stretch.flush(outputView, outputSamples);
+}
+
 inline void signalsmith_stretch_process(
     SignalsmithStretchFloat& stretch,
     const float* const* inputs, int inputSamples,
     float** outputs, int outputSamples,
     int channels
 ) {
-    FloatBufferView inputView(inputs, channels);
-    FloatBufferMutView outputView(outputs, channels);
-    stretch.process(inputView, inputSamples, outputView, outputSamples);
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->processFloat(stretch, inputs, inputSamples, outputs, outputSamples);
+        return;
+    }
+#endif
+    stretchProcess(stretch, inputs, inputSamples, outputs, outputSamples, channels);
 }
 
-// Seek wrapper
 inline void signalsmith_stretch_seek(
     SignalsmithStretchFloat& stretch,
     const float* const* inputs, int inputSamples,
     double playbackRate,
     int channels
 ) {
-    FloatBufferView inputView(inputs, channels);
-    stretch.seek(inputView, inputSamples, playbackRate);
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->seekFloat(stretch, inputs, inputSamples, playbackRate);
+        return;
+    }
+#endif
+    stretchSeek(stretch, inputs, inputSamples, playbackRate, channels);
 }
 
-// Flush wrapper
 inline void signalsmith_stretch_flush(
     SignalsmithStretchFloat& stretch,
     float** outputs, int outputSamples,
     int channels
 ) {
-    FloatBufferMutView outputView(outputs, channels);
-    stretch.flush(outputView, outputSamples);
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->flushFloat(stretch, outputs, outputSamples);
+        return;
+    }
+#endif
+    stretchFlush(stretch, outputs, outputSamples, channels);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TimeStretch API (double precision)
+///////////////////////////////////////////////////////////////////////////////
+
+inline size_t signalsmith_stretch_double_object_size() {
+    return sizeof(SignalsmithStretchDouble);
+}
+
+inline std::unique_ptr<SignalsmithStretchDouble> new_signalsmith_stretch_double() {
+    return std::make_unique<SignalsmithStretchDouble>();
+}
+
+inline std::unique_ptr<SignalsmithStretchDouble> new_signalsmith_stretch_double_with_seed(int64_t seed) {
+    return std::make_unique<SignalsmithStretchDouble>(static_cast<long long>(seed));
+}
+
+inline void signalsmith_stretch_double_process(
+    SignalsmithStretchDouble& stretch,
+    const double* const* inputs, int inputSamples,
+    double** outputs, int outputSamples,
+    int channels
+) {
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->processDouble(stretch, inputs, inputSamples, outputs, outputSamples);
+        return;
+    }
+#endif
+    stretchProcess(stretch, inputs, inputSamples, outputs, outputSamples, channels);
+}
+
+inline void signalsmith_stretch_double_seek(
+    SignalsmithStretchDouble& stretch,
+    const double* const* inputs, int inputSamples,
+    double playbackRate,
+    int channels
+) {
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->seekDouble(stretch, inputs, inputSamples, playbackRate);
+        return;
+    }
+#endif
+    stretchSeek(stretch, inputs, inputSamples, playbackRate, channels);
+}
+
+inline void signalsmith_stretch_double_flush(
+    SignalsmithStretchDouble& stretch,
+    double** outputs, int outputSamples,
+    int channels
+) {
+#ifdef SSSTRETCH_CPU_DISPATCH
+    if (const StretchKernels *kernels = activeStretchKernels()) {
+        kernels->flushDouble(stretch, outputs, outputSamples);
+        return;
+    }
+#endif
+    stretchFlush(stretch, outputs, outputSamples, channels);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -285,4 +432,8 @@ inline void biquad_process_buffer(
 // Reset filter state
 inline void biquad_reset(BiquadStaticFloat& filter) {
     filter.reset();
+}
+
+inline size_t biquad_object_size() {
+    return sizeof(BiquadStaticFloat);
 }
\ No newline at end of file
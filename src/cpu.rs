@@ -0,0 +1,77 @@
+use crate::ffi;
+use std::fmt;
+
+/// Instruction set used by the stretcher's processing code.
+///
+/// With the `cpu-dispatch` feature on x86/x86_64 (GCC or Clang), the C++ core is also
+/// compiled for AVX2 and AVX-512 and the best one the CPU supports is picked on first
+/// use. Otherwise only the baseline build exists: SSE2 on x86_64, NEON on aarch64
+/// (always available there), or whatever the target's default flags allow.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum Isa {
+    /// Built with the target's default flags.
+    Baseline,
+    /// AVX2 + FMA.
+    Avx2,
+    /// AVX-512 (F, DQ, VL).
+    Avx512,
+}
+
+impl From<Isa> for i32 {
+    fn from(isa: Isa) -> Self {
+        match isa {
+            Isa::Baseline => 0, // Values match StretchIsa in dispatch.h
+            Isa::Avx2 => 1,
+            Isa::Avx512 => 2,
+        }
+    }
+}
+
+impl fmt::Display for Isa {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let name = match self {
+            Isa::Baseline if cfg!(target_arch = "x86_64") => "sse2",
+            Isa::Baseline if cfg!(target_arch = "aarch64") => "neon",
+            Isa::Baseline => "baseline",
+            Isa::Avx2 => "avx2",
+            Isa::Avx512 => "avx512",
+        };
+        f.write_str(name)
+    }
+}
+
+impl Isa {
+    fn from_raw(isa: i32) -> Self {
+        match isa {
+            2 => Isa::Avx512,
+            1 => Isa::Avx2,
+            _ => Isa::Baseline,
+        }
+    }
+}
+
+/// The instruction set currently used by `Stretch::process`, `seek` and `flush`.
+pub fn active_isa() -> Isa {
+    Isa::from_raw(ffi::stretch_active_isa())
+}
+
+/// The best instruction set this build can run on this CPU (selected by default).
+pub fn best_isa() -> Isa {
+    Isa::from_raw(ffi::stretch_supported_isa())
+}
+
+/// Switch all stretchers to `isa`, e.g. to compare paths in a benchmark.
+///
+/// Returns `false` (leaving the selection unchanged) if this build or CPU can't run it.
+pub fn select_isa(isa: Isa) -> bool {
+    ffi::stretch_select_isa(isa.into())
+}
+
+/// Every instruction set this build can run on this CPU, from baseline upwards.
+pub fn supported_isas() -> Vec<Isa> {
+    let best = best_isa();
+    [Isa::Baseline, Isa::Avx2, Isa::Avx512]
+        .into_iter()
+        .filter(|&isa| isa <= best)
+        .collect()
+}
@@ -0,0 +1,130 @@
+//! Flush-to-zero / denormals-are-zero control for the DSP entry points.
+//!
+//! Decaying signals and filter/feedback state eventually reach the denormal range,
+//! where x86 CPUs slow down by 10-100x. With flushing enabled, `Stretch::process`,
+//! `seek` and `flush`, `BiquadFilter::process_buffer` and `Delay::process_buffer` set
+//! FTZ/DAZ (MXCSR on x86, FZ in FPCR on aarch64) for the duration of the call and
+//! restore the caller's state afterwards. On other targets this is a no-op.
+
+use std::sync::atomic::{AtomicBool, Ordering};
+
+static FLUSH_DENORMALS_DEFAULT: AtomicBool = AtomicBool::new(false);
+
+/// Set whether newly created stretchers, filters and delays flush denormals.
+///
+/// Existing instances keep their setting; change those with their own `set_flush_denormals`.
+pub fn set_flush_denormals_default(enabled: bool) {
+    FLUSH_DENORMALS_DEFAULT.store(enabled, Ordering::Relaxed);
+}
+
+/// Whether newly created instances flush denormals (`false` unless changed).
+pub fn flush_denormals_default() -> bool {
+    FLUSH_DENORMALS_DEFAULT.load(Ordering::Relaxed)
+}
+
+/// Enables flush-to-zero and denormals-are-zero on this thread until dropped,
+/// then restores the previous floating-point control state.
+pub struct DenormalGuard {
+    previous: arch::Control,
+    // The control register is per-thread, so the guard must be dropped where it was made
+    _not_send: std::marker::PhantomData<*const ()>,
+}
+
+impl DenormalGuard {
+    /// Enable FTZ/DAZ on the current thread.
+    pub fn new() -> Self {
+        let previous = arch::read();
+        arch::write(arch::flushing(previous));
+        Self {
+            previous,
+            _not_send: std::marker::PhantomData,
+        }
+    }
+
+    /// A guard if `enabled`, otherwise nothing (and no register access).
+    pub(crate) fn when(enabled: bool) -> Option<Self> {
+        if enabled {
+            Some(Self::new())
+        } else {
+            None
+        }
+    }
+}
+
+impl Default for DenormalGuard {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for DenormalGuard {
+    fn drop(&mut self) {
+        arch::write(self.previous);
+    }
+}
+
+#[cfg(all(any(target_arch = "x86", target_arch = "x86_64"), target_feature = "sse"))]
+mod arch {
+    use std::arch::asm;
+
+    pub type Control = u32;
+
+    // FTZ (bit 15) and DAZ (bit 6) in MXCSR
+    pub fn flushing(csr: Control) -> Control {
+        csr | 0x8040
+    }
+
+    pub fn read() -> Control {
+        let mut csr: Control = 0;
+        unsafe {
+            asm!("stmxcsr [{}]", in(reg) &mut csr, options(nostack, preserves_flags));
+        }
+        csr
+    }
+
+    pub fn write(csr: Control) {
+        unsafe {
+            asm!("ldmxcsr [{}]", in(reg) &csr, options(nostack, readonly, preserves_flags));
+        }
+    }
+}
+
+#[cfg(target_arch = "aarch64")]
+mod arch {
+    use std::arch::asm;
+
+    pub type Control = u64;
+
+    // FZ (bit 24) in FPCR; aarch64 has no separate input flag
+    pub fn flushing(fpcr: Control) -> Control {
+        fpcr | 1 << 24
+    }
+
+    pub fn read() -> Control {
+        let fpcr: Control;
+        unsafe {
+            asm!("mrs {}, fpcr", out(reg) fpcr, options(nomem, nostack, preserves_flags));
+        }
+        fpcr
+    }
+
+    pub fn write(fpcr: Control) {
+        unsafe {
+            asm!("msr fpcr, {}", in(reg) fpcr, options(nomem, nostack, preserves_flags));
+        }
+    }
+}
+
+#[cfg(not(any(
+    all(any(target_arch = "x86", target_arch = "x86_64"), target_feature = "sse"),
+    target_arch = "aarch64"
+)))]
+mod arch {
+    pub type Control = ();
+
+    pub fn flushing(_: Control) -> Control {}
+
+    pub fn read() -> Control {}
+
+    pub fn write(_: Control) {}
+}
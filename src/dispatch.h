@@ -0,0 +1,30 @@
+#pragma once
+
+#include "./signalsmith-stretch/signalsmith-stretch.h"
+
+// Processing entry points built for wider instruction sets (see dispatch_isa.cc).
+// They take the same stretcher objects as the baseline path.
+struct StretchKernels {
+    using Float = signalsmith::stretch::SignalsmithStretch<float>;
+    using Double = signalsmith::stretch::SignalsmithStretch<double>;
+
+    void (*processFloat)(Float &stretch, const float* const* inputs, int inputSamples, float** outputs, int outputSamples);
+    void (*seekFloat)(Float &stretch, const float* const* inputs, int inputSamples, double playbackRate);
+    void (*flushFloat)(Float &stretch, float** outputs, int outputSamples);
+    void (*processDouble)(Double &stretch, const double* const* inputs, int inputSamples, double** outputs, int outputSamples);
+    void (*seekDouble)(Double &stretch, const double* const* inputs, int inputSamples, double playbackRate);
+    void (*flushDouble)(Double &stretch, double** outputs, int outputSamples);
+};
+
+// Values match the `Isa` enum in cpu.rs
+enum StretchIsa {
+    stretchIsaBaseline = 0,
+    stretchIsaAvx2 = 1,
+    stretchIsaAvx512 = 2,
+};
+
+extern const StretchKernels stretchKernelsAvx2;
+extern const StretchKernels stretchKernelsAvx512;
+
+// Kernels for the selected instruction set, or nullptr to use the baseline build
+const StretchKernels * activeStretchKernels();
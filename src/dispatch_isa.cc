@@ -0,0 +1,35 @@
+// Processing entry points for wider instruction sets, picked at runtime by
+// activeStretchKernels() in bridge.cc. Built with the baseline flags, like bridge.cc.
+//
+// Each entry point is marked with `target` for its instruction set and `flatten`, which
+// inlines the whole call tree below it. The stretcher code therefore runs with that
+// instruction set on the same SignalsmithStretch objects the baseline path uses, while
+// the out-of-line copies of its templates stay baseline code that any CPU can run.
+
+#include "./dispatch.h"
+
+#define SSSTRETCH_KERNELS(table, isa) \
+    namespace { namespace table##Entry { \
+        template<typename Sample> \
+        __attribute__((target(isa), flatten)) \
+        void process(signalsmith::stretch::SignalsmithStretch<Sample> &stretch, const Sample* const* inputs, int inputSamples, Sample** outputs, int outputSamples) { \
+            stretch.process(inputs, inputSamples, outputs, outputSamples); \
+        } \
+        template<typename Sample> \
+        __attribute__((target(isa), flatten)) \
+        void seek(signalsmith::stretch::SignalsmithStretch<Sample> &stretch, const Sample* const* inputs, int inputSamples, double playbackRate) { \
+            stretch.seek(inputs, inputSamples, playbackRate); \
+        } \
+        template<typename Sample> \
+        __attribute__((target(isa), flatten)) \
+        void flush(signalsmith::stretch::SignalsmithStretch<Sample> &stretch, Sample** outputs, int outputSamples) { \
+            stretch.flush(outputs, outputSamples); \
+        } \
+    } } \
+    extern const StretchKernels table = { \
+        table##Entry::process<float>, table##Entry::seek<float>, table##Entry::flush<float>, \
+        table##Entry::process<double>, table##Entry::seek<double>, table##Entry::flush<double>, \
+    };
+
+SSSTRETCH_KERNELS(stretchKernelsAvx2, "avx2,fma")
+SSSTRETCH_KERNELS(stretchKernelsAvx512, "avx512f,avx512dq,avx512vl,avx2,fma")
@@ -1,7 +1,10 @@
+use crate::denormals::{self, DenormalGuard};
+
 /// Simple fractional-delay line for single channel audio.
 pub struct Delay {
     buffer: Vec<f32>,
     write_index: usize,
+    flush_denormals: bool,
 }
 
 impl Delay {
@@ -11,6 +14,7 @@ impl Delay {
         Self {
             buffer: vec![0.0; capacity],
             write_index: 0,
+            flush_denormals: denormals::flush_denormals_default(),
         }
     }
 
@@ -35,6 +39,20 @@ impl Delay {
         self.write_index = (self.write_index + 1) % len;
         y
     }
+
+    /// Process a buffer of samples with a fixed delay length.
+    pub fn process_buffer(&mut self, input: &[f32], output: &mut [f32], delay_samples: f32) {
+        let _denormals = DenormalGuard::when(self.flush_denormals);
+        for (x, y) in input.iter().zip(output.iter_mut()) {
+            *y = self.process(*x, delay_samples);
+        }
+    }
+
+    /// Flush denormals to zero in `process_buffer`, restoring the caller's
+    /// floating-point state afterwards.
+    pub fn set_flush_denormals(&mut self, enabled: bool) {
+        self.flush_denormals = enabled;
+    }
 }
 
 /// Multi-channel wrapper around `Delay` with independent state per channel.
@@ -17,6 +17,7 @@ mod backend {
 
     impl FFT {
         pub fn new(size: usize) -> Self {
+            let _span = span!(DEBUG, "fft_plan", size);
             let mut planner = FftPlanner::new();
             let forward = planner.plan_fft_forward(size);
             let inverse = planner.plan_fft_inverse(size);
@@ -25,6 +26,11 @@ mod backend {
 
         pub fn optimal_size(min_size: usize) -> usize { min_size.next_power_of_two() }
 
+        /// Approximate memory held by the plans in bytes (one set of twiddles per direction)
+        pub fn memory_usage(&self) -> usize {
+            std::mem::size_of::<Self>() + 2 * self.size * std::mem::size_of::<Cmplx>()
+        }
+
         pub fn forward(&mut self, input: &[ComplexFloat], output: &mut [ComplexFloat]) {
             assert_eq!(input.len(), self.size);
             assert_eq!(output.len(), self.size);
@@ -56,6 +62,7 @@ mod backend {
 
     impl RealFFT {
         pub fn new(size: usize) -> Self {
+            let _span = span!(DEBUG, "real_fft_plan", size);
             let mut planner = RealFftPlanner::<f32>::new();
             let r2c = planner.plan_fft_forward(size);
             let c2r = planner.plan_fft_inverse(size);
@@ -64,6 +71,12 @@ mod backend {
             Self { size, r2c, c2r, scratch_fwd, scratch_inv }
         }
 
+        /// Approximate memory held by the plans and scratch buffers in bytes
+        pub fn memory_usage(&self) -> usize {
+            let scratch = self.scratch_fwd.capacity() + self.scratch_inv.capacity();
+            std::mem::size_of::<Self>() + (self.size + scratch) * std::mem::size_of::<Cmplx>()
+        }
+
         pub fn forward(&mut self, input: &[f32], output: &mut [ComplexFloat]) {
             assert_eq!(input.len(), self.size);
             assert_eq!(output.len(), self.size / 2 + 1);
@@ -100,6 +113,7 @@ mod backend {
     impl FFT {
         pub fn new(size: usize) -> Self { Self { size } }
         pub fn optimal_size(min_size: usize) -> usize { min_size.next_power_of_two() }
+        pub fn memory_usage(&self) -> usize { std::mem::size_of::<Self>() }
         pub fn forward(&mut self, input: &[ComplexFloat], output: &mut [ComplexFloat]) {
             let n = self.size; assert_eq!(input.len(), n); assert_eq!(output.len(), n);
             let two_pi_over_n = 2.0_f32 * std::f32::consts::PI / n as f32;
@@ -118,6 +132,7 @@ mod backend {
     pub struct RealFFT { size: usize }
     impl RealFFT {
         pub fn new(size: usize) -> Self { Self { size } }
+        pub fn memory_usage(&self) -> usize { std::mem::size_of::<Self>() }
         pub fn forward(&mut self, input: &[f32], output: &mut [ComplexFloat]) {
             let n = self.size; assert_eq!(input.len(), n); assert_eq!(output.len(), n/2 + 1);
             let mut tmp_in = vec![ComplexFloat::new(0.0,0.0); n]; for (i,&v) in input.iter().enumerate(){ tmp_in[i]=ComplexFloat::new(v,0.0);} 
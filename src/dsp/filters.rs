@@ -1,3 +1,4 @@
+use crate::denormals::{self, DenormalGuard};
 use crate::ffi;
 
 /// Biquad filter design methods
@@ -48,6 +49,7 @@ pub enum FilterType {
 /// Biquad filter implementation with static coefficients
 pub struct BiquadFilter {
     inner: cxx::UniquePtr<ffi::BiquadStaticFloat>,
+    flush_denormals: bool,
 }
 
 impl BiquadFilter {
@@ -55,6 +57,7 @@ impl BiquadFilter {
     pub fn new() -> Self {
         Self {
             inner: ffi::new_biquad(),
+            flush_denormals: denormals::flush_denormals_default(),
         }
     }
     
@@ -163,6 +166,7 @@ impl BiquadFilter {
     /// Process a buffer of samples through the filter
     pub fn process_buffer(&mut self, input: &[f32], output: &mut [f32]) {
         let len = input.len().min(output.len()) as i32;
+        let _denormals = DenormalGuard::when(self.flush_denormals);
         
         unsafe {
             ffi::biquad_process_buffer(
@@ -174,10 +178,32 @@ impl BiquadFilter {
         }
     }
     
+    /// Filter `samples` in place.
+    pub(crate) fn process_in_place(&mut self, samples: &mut [f32]) {
+        let _denormals = DenormalGuard::when(self.flush_denormals);
+        let ptr = samples.as_mut_ptr();
+        // The C++ loop reads each input sample before writing the same index
+        unsafe {
+            ffi::biquad_process_buffer(self.inner.pin_mut(), ptr, ptr, samples.len() as i32);
+        }
+    }
+    
+    /// Flush denormals to zero in `process_buffer`, so a decaying filter tail
+    /// doesn't slow down. The caller's floating-point state is restored afterwards.
+    pub fn set_flush_denormals(&mut self, enabled: bool) -> &mut Self {
+        self.flush_denormals = enabled;
+        self
+    }
+    
     /// Reset the filter state
     pub fn reset(&mut self) {
         ffi::biquad_reset(self.inner.pin_mut());
     }
+
+    /// Memory held by the filter in bytes (the C++ object has no heap allocations)
+    pub fn memory_usage(&self) -> usize {
+        ffi::biquad_object_size()
+    }
 }
 
 impl Default for BiquadFilter {
@@ -1,5 +1,23 @@
+use crate::allocator::{stretch_allocator_allocate, stretch_allocator_deallocate, AllocatorHandle};
+
 #[cxx::bridge]
 pub mod bindings {
+    extern "Rust" {
+        // Allocator receiving C++ allocations, see allocator.rs
+        type AllocatorHandle;
+        unsafe fn stretch_allocator_allocate(
+            handle: &AllocatorHandle,
+            size: usize,
+            align: usize,
+        ) -> *mut u8;
+        unsafe fn stretch_allocator_deallocate(
+            handle: &AllocatorHandle,
+            ptr: *mut u8,
+            size: usize,
+            align: usize,
+        );
+    }
+
     unsafe extern "C++" {
         include!("bridge.h");
 
@@ -9,6 +27,7 @@ pub mod bindings {
         
         // Main TimeStretch type
         type SignalsmithStretchFloat;
+        type SignalsmithStretchDouble;
         
         // Filter Types
         type BiquadStaticFloat;
@@ -27,6 +46,20 @@ pub mod bindings {
         fn inputLatency(self: &SignalsmithStretchFloat) -> i32;
         fn outputLatency(self: &SignalsmithStretchFloat) -> i32;
 
+        // Size of the C++ object itself, excluding heap allocations
+        fn signalsmith_stretch_object_size() -> usize;
+
+        // Route C++ allocations on this thread to a Rust allocator (see bridge.cc)
+        fn set_stretch_allocator(allocator: &AllocatorHandle);
+        fn clear_stretch_allocator();
+        fn cxx_allocation_count() -> u64;
+        fn cxx_allocated_bytes() -> u64;
+
+        // Runtime CPU dispatch (see bridge.cc and cpu.rs)
+        fn stretch_active_isa() -> i32;
+        fn stretch_supported_isa() -> i32;
+        fn stretch_select_isa(isa: i32) -> bool;
+
         // Configuration methods
         fn reset(self: Pin<&mut SignalsmithStretchFloat>);
         fn presetDefault(self: Pin<&mut SignalsmithStretchFloat>, nChannels: i32, sampleRate: f32);
@@ -75,6 +108,64 @@ pub mod bindings {
             channels: i32,
         );
                 
+        //////////////////////////
+        // TimeStretch (double precision) Factory + Methods
+        //////////////////////////
+
+        fn new_signalsmith_stretch_double() -> UniquePtr<SignalsmithStretchDouble>;
+        fn new_signalsmith_stretch_double_with_seed(seed: i64) -> UniquePtr<SignalsmithStretchDouble>;
+        fn signalsmith_stretch_double_object_size() -> usize;
+
+        fn blockSamples(self: &SignalsmithStretchDouble) -> i32;
+        fn intervalSamples(self: &SignalsmithStretchDouble) -> i32;
+        fn inputLatency(self: &SignalsmithStretchDouble) -> i32;
+        fn outputLatency(self: &SignalsmithStretchDouble) -> i32;
+
+        fn reset(self: Pin<&mut SignalsmithStretchDouble>);
+        fn presetDefault(self: Pin<&mut SignalsmithStretchDouble>, nChannels: i32, sampleRate: f64);
+        fn presetCheaper(self: Pin<&mut SignalsmithStretchDouble>, nChannels: i32, sampleRate: f64);
+        fn configure(
+            self: Pin<&mut SignalsmithStretchDouble>,
+            nChannels: i32,
+            blockSamples: i32,
+            intervalSamples: i32,
+        );
+
+        fn setTransposeFactor(
+            self: Pin<&mut SignalsmithStretchDouble>,
+            multiplier: f64,
+            tonalityLimit: f64,
+        );
+        fn setTransposeSemitones(
+            self: Pin<&mut SignalsmithStretchDouble>,
+            semitones: f64,
+            tonalityLimit: f64,
+        );
+
+        unsafe fn signalsmith_stretch_double_process(
+            stretch: Pin<&mut SignalsmithStretchDouble>,
+            inputs: *const *const f64,
+            inputSamples: i32,
+            outputs: *mut *mut f64,
+            outputSamples: i32,
+            channels: i32,
+        );
+
+        unsafe fn signalsmith_stretch_double_seek(
+            stretch: Pin<&mut SignalsmithStretchDouble>,
+            inputs: *const *const f64,
+            inputSamples: i32,
+            playbackRate: f64,
+            channels: i32,
+        );
+
+        unsafe fn signalsmith_stretch_double_flush(
+            stretch: Pin<&mut SignalsmithStretchDouble>,
+            outputs: *mut *mut f64,
+            outputSamples: i32,
+            channels: i32,
+        );
+
         //////////////////////////
         // Biquad Filter Methods
         //////////////////////////
@@ -96,8 +187,17 @@ pub mod bindings {
         fn biquad_process_sample(filter: Pin<&mut BiquadStaticFloat>, sample: f32) -> f32;
         unsafe fn biquad_process_buffer(filter: Pin<&mut BiquadStaticFloat>, input: *const f32, output: *mut f32, samples: i32);
         fn biquad_reset(filter: Pin<&mut BiquadStaticFloat>);
+
+        // Size of the C++ filter object (it holds no heap allocations)
+        fn biquad_object_size() -> usize;
     }
 }
 
+// The C++ objects own all their state and have no thread affinity, so they can be
+// moved to another thread (but not shared: every mutating call takes Pin<&mut>)
+unsafe impl Send for bindings::SignalsmithStretchFloat {}
+unsafe impl Send for bindings::SignalsmithStretchDouble {}
+unsafe impl Send for bindings::BiquadStaticFloat {}
+
 // Re-export the FFI bindings for use by the rest of the crate
 pub use bindings::*;
\ No newline at end of file
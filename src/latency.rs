@@ -0,0 +1,59 @@
+//! Choosing a configuration for a latency budget, and estimating its processing cost.
+//!
+//! The stretcher's latency follows its block length, and its cost follows the FFT size
+//! and how often blocks are processed. `StretchBuilder::preset_for_latency` picks the
+//! longest block that fits a budget, snapped down to an FFT size so no work goes into
+//! zero-padding, with the cheaper preset's (2.5x) overlap. The fit is checked against the
+//! latencies the configured core reports, not a model of them. `Stretch::latency_report`
+//! then reports the chosen sizes, the resulting latency and the estimated cost.
+//!
+//! Cost estimates come from a model of the work per block (FFTs plus per-band analysis and
+//! synthesis), relative to `preset_default` at the same sample rate. They rank
+//! configurations well; measure with a `DeadlineMonitor` for absolute figures.
+
+use crate::memory::fft_size_above;
+
+/// Interval as a fraction of the block, as in the C++ core's `presetCheaper()`.
+pub(crate) const INTERVAL_RATIO: f32 = 0.4;
+
+/// Smallest block `preset_for_latency` goes down to, however tight the budget.
+pub(crate) const MIN_BLOCK_SAMPLES: usize = 64;
+
+// Per-band work per block (peak finding, phase prediction, output mapping) in units of
+// one FFT butterfly stage per band
+const BAND_WORK: f32 = 6.0;
+
+/// Modelled work per second of audio for one channel, in arbitrary units.
+fn work_per_second(sample_rate: f32, block_samples: i32, interval_samples: i32) -> f32 {
+    let fft_size = fft_size_above(block_samples.max(1) as usize) as f32;
+    // Forward and inverse FFT per block, plus the per-band processing
+    let per_block = fft_size * (2.0 * fft_size.log2() + BAND_WORK);
+    per_block * sample_rate / interval_samples.max(1) as f32
+}
+
+/// Estimated processing cost of `configure(block_samples, interval_samples)` relative to
+/// `preset_default` at the same sample rate (1.0 is the same cost).
+pub fn relative_cpu(sample_rate: f32, block_samples: i32, interval_samples: i32) -> f32 {
+    // Mirrors SignalsmithStretch::presetDefault()
+    let default = work_per_second(
+        sample_rate,
+        (sample_rate * 0.12) as i32,
+        (sample_rate * 0.03) as i32,
+    );
+    work_per_second(sample_rate, block_samples, interval_samples) / default
+}
+
+/// A stretcher's configuration, latency and estimated cost (see `Stretch::latency_report`).
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct LatencyReport {
+    /// Block length in samples.
+    pub block_samples: i32,
+    /// Interval between blocks in samples.
+    pub interval_samples: i32,
+    /// Input plus output latency in input samples.
+    pub latency_samples: i32,
+    /// Input plus output latency in milliseconds.
+    pub latency_ms: f32,
+    /// Estimated processing cost relative to `preset_default` (see `relative_cpu`).
+    pub relative_cpu: f32,
+}
@@ -7,12 +7,34 @@
 pub use stretch::Stretch;
 pub use stretch::StretchBuilder;
 pub use dsp::filters::BiquadFilter;
+pub use memory::MemoryUsage;
+pub use latency::LatencyReport;
+#[cfg(feature = "custom-allocator")]
+pub use allocator::{CxxAllocations, StretchAllocator};
+pub use sample::StretchSample;
+pub use denormals::DenormalGuard;
+pub use monitor::DeadlineMonitor;
+pub use render::ParallelRender;
+pub use stems::LinkedStems;
+pub use multiband::MultibandStretch;
 pub use num_complex::Complex32 as ComplexFloat;
 
 // Import submodules
+#[macro_use]
+mod trace;
 pub mod stretch;
 pub mod dsp;
 pub mod util;
+pub mod memory;
+pub mod latency;
+mod allocator;
+pub mod sample;
+pub mod cpu;
+pub mod denormals;
+pub mod monitor;
+pub mod render;
+pub mod stems;
+pub mod multiband;
 mod ffi;
 
 #[cfg(test)]
@@ -27,6 +49,370 @@ mod tests {
         assert_eq!(2, 2); // Channels is part of the type now
     }
     
+    #[test]
+    fn test_stretch_is_send() {
+        fn assert_send<T: Send>() {}
+        assert_send::<Stretch<2>>();
+        assert_send::<Stretch<2, f64>>();
+        assert_send::<BiquadFilter>();
+    }
+
+    #[test]
+    fn test_stretch_f64() {
+        let mut stretch = Stretch::<2, f64>::new(48000.0);
+        let input = [vec![0.5f64; 4800], vec![-0.5f64; 4800]];
+        let mut output = [vec![0.0f64; 9600], vec![0.0f64; 9600]];
+        stretch.process_vec(&input, 4800, &mut output, 9600);
+        assert!(stretch.memory_usage().total() > Stretch::<2>::new(48000.0).memory_usage().total());
+    }
+
+    #[test]
+    fn test_parallel_render_length() {
+        let input = vec![0.25f32; 48000 * 4];
+        let output = ParallelRender::new(48000.0)
+            .threads(2)
+            .segment_seconds(1.0)
+            .render([&input[..]], 1.5, || Stretch::<1>::new(48000.0));
+        assert_eq!(output[0].len(), 48000 * 6);
+    }
+
+    #[test]
+    fn test_parallel_render_boundaries() {
+        let input: Vec<f32> = (0..48000 * 8)
+            .map(|i| {
+                let t = i as f32 / 48000.0;
+                0.3 * (std::f32::consts::TAU * 220.0 * t).sin()
+                    + 0.2 * (std::f32::consts::TAU * 330.5 * t).sin()
+            })
+            .collect();
+        let make = || Stretch::<1>::new(48000.0);
+        let render = |ratio: f64, segment_seconds: f32| {
+            ParallelRender::new(48000.0)
+                .threads(2)
+                .segment_seconds(segment_seconds)
+                .render([&input[..]], ratio, make)
+                .remove(0)
+        };
+        let step = |samples: &[f32]| {
+            samples.windows(2).map(|pair| (pair[1] - pair[0]).abs()).fold(0.0, f32::max)
+        };
+        for ratio in [1.0, 1.5] {
+            // One segment is a single-instance render
+            let single = render(ratio, 10.0);
+            let parallel = render(ratio, 2.0);
+            let steady = step(&single[4800..single.len() - 4800]);
+            for second in [2, 4, 6] {
+                let boundary = (second as f64 * 48000.0 * ratio) as usize;
+                let around = boundary - 4800..boundary + 4800;
+                // No click: the output moves no faster across the boundary than elsewhere
+                assert!(step(&parallel[around.clone()]) < 1.5 * steady);
+                if ratio == 1.0 {
+                    let difference = parallel[around.clone()]
+                        .iter()
+                        .zip(&single[around])
+                        .map(|(a, b)| (a - b).abs())
+                        .fold(0.0, f32::max);
+                    assert!(difference < 0.05, "{difference} at {boundary}");
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_linked_stems_layout() {
+        let mut stems = LinkedStems::new(Stretch::<3>::new(48000.0), &[2, 1]);
+        assert_eq!(stems.stems(), 2);
+        assert_eq!(stems.stem_channels(1), 2..3);
+        let input = vec![vec![vec![0.25f32; 480]; 2], vec![vec![-0.25f32; 480]]];
+        let mut output = vec![vec![Vec::new(); 2], vec![Vec::new()]];
+        stems.process(&input, 480, &mut output, 960);
+        assert!(output.iter().flatten().all(|channel| channel.len() == 960));
+    }
+
+    #[test]
+    fn test_linked_stems_sum_to_mix() {
+        // Two stems, and their mix as a third stem following the same decisions
+        let tone = |freq: f32| -> Vec<f32> {
+            (0..48000)
+                .map(|i| 0.3 * (std::f32::consts::TAU * freq * i as f32 / 48000.0).sin())
+                .collect()
+        };
+        let (low, high) = (tone(220.0), tone(330.5));
+        let mix = low.iter().zip(&high).map(|(a, b)| a + b).collect();
+        let mut stems = LinkedStems::new(Stretch::<3>::new(48000.0), &[1, 1, 1]);
+        let input = vec![vec![low], vec![high], vec![mix]];
+        let mut output = vec![vec![Vec::new()]; 3];
+        stems.process(&input, 48000, &mut output, 72000);
+
+        // Past the start-up, the stretched stems add up to the stretched mix to within
+        // -20 dB (exactly, for a core that is linear in its input)
+        let steady = 24000..72000;
+        let (mut error, mut energy) = (0.0, 0.0);
+        for i in steady {
+            let mix = output[2][0][i];
+            error += (output[0][0][i] + output[1][0][i] - mix).powi(2);
+            energy += mix.powi(2);
+        }
+        assert!(error < 0.01 * energy, "{error} vs {energy}");
+    }
+
+    #[test]
+    fn test_multiband_layout() {
+        // 500 Hz stays below 1/8 of 48 kHz / 8, but not of 48 kHz / 16
+        let mut multiband = MultibandStretch::<2>::two_band(48000.0, 500.0);
+        assert_eq!(multiband.bands(), 2);
+        let blocks = |seconds: f32, decimation: f32| (seconds * 48000.0 / decimation).round() as i32;
+        assert_eq!(multiband.band(0).block_samples(), blocks(0.12, 8.0));
+        assert_eq!(multiband.band(1).block_samples(), blocks(0.04, 1.0));
+        assert!(multiband.input_latency() >= multiband.band(1).input_latency() as usize);
+
+        let input = vec![0.25f32; 1024];
+        let mut left = vec![1.0f32; 1024];
+        let mut right = vec![1.0f32; 1024];
+        multiband.seek([&input, &input], 1.0);
+        multiband.process([&input, &input], &mut [&mut left, &mut right]);
+        assert!(left.iter().chain(&right).all(|sample| sample.is_finite()));
+        multiband.flush(&mut [&mut left, &mut right]);
+        assert!(left.iter().chain(&right).all(|sample| sample.is_finite()));
+    }
+
+    #[test]
+    fn test_multiband_split_reconstructs() {
+        use crate::multiband::BandConfig;
+        // Linkwitz-Riley bands add up to the input through an allpass per crossover
+        let crossovers = [200.0, 2000.0];
+        let band = BandConfig { block_seconds: 0.04, interval_seconds: 0.01, decimation: 1 };
+        let mut multiband = MultibandStretch::<1>::new(48000.0, &crossovers, &[band; 3]);
+        let input: Vec<f32> = (0..4800)
+            .map(|i| (i as f32 * 0.01).sin() * 0.3 + (i as f32 * 0.37).sin() * 0.2)
+            .collect();
+        let mut expected = input.clone();
+        for freq in crossovers {
+            let mut allpass = BiquadFilter::new();
+            allpass.allpass(freq / 48000.0, std::f32::consts::FRAC_1_SQRT_2, None);
+            let staged = expected.clone();
+            allpass.process_buffer(&staged, &mut expected);
+        }
+        let bands = multiband.split([&input]);
+        for (i, expected) in expected.iter().enumerate() {
+            let sum: f32 = bands.iter().map(|band| band[0][i]).sum();
+            assert!((sum - expected).abs() < 1e-4, "{sum} != {expected} at {i}");
+        }
+    }
+
+    #[test]
+    fn test_multiband_rate_change_phase() {
+        use crate::multiband::{rate_change, rate_change_allpasses};
+        // Below the cutoff, a decimated band's two low-passes (anti-aliasing and
+        // interpolation) match the allpass the other bands get, in phase and level
+        let decimation = 8;
+        let input: Vec<f32> = (0..48000)
+            .map(|i| {
+                let t = i as f32 / 48000.0;
+                0.3 * (std::f32::consts::TAU * 110.0 * t).sin()
+                    + 0.2 * (std::f32::consts::TAU * 700.0 * t).sin()
+                    + 0.1 * (std::f32::consts::TAU * 1500.0 * t).sin()
+            })
+            .collect();
+        let mut lowpassed = input.clone();
+        for mut chain in [rate_change::<1>(decimation), rate_change::<1>(decimation)] {
+            for filter in &mut chain[0] {
+                filter.process_in_place(&mut lowpassed);
+            }
+        }
+        let mut allpassed = input;
+        for filter in &mut rate_change_allpasses::<1>(&[decimation])[0] {
+            filter.process_in_place(&mut allpassed);
+        }
+        // Past the filters' settling time, to within 1e-3 (a delay matching their group
+        // delay at 0 Hz instead is off by almost 0.1)
+        for i in 4800..48000 {
+            let difference = (lowpassed[i] - allpassed[i]).abs();
+            assert!(difference < 1e-3, "{difference} at {i}");
+        }
+    }
+
+    #[test]
+    fn test_high_rate_audible_band() {
+        // 192 kHz is stretched at 48 kHz, 88.2 kHz at 44.1 kHz, with the default timing
+        let block = |rate: f32| (0.12 * rate).round() as i32;
+        let mut high_rate = MultibandStretch::<2>::high_rate(192_000.0);
+        assert_eq!(high_rate.band(0).block_samples(), block(192_000.0 / 4.0));
+        let low = MultibandStretch::<2>::high_rate(88_200.0);
+        assert_eq!(low.band(0).block_samples(), block(88_200.0 / 2.0));
+
+        let input = vec![0.25f32; 4096];
+        let mut left = vec![1.0f32; 2048];
+        let mut right = vec![1.0f32; 2048];
+        high_rate.process([&input, &input], &mut [&mut left, &mut right]);
+        assert!(left.iter().chain(&right).all(|sample| sample.is_finite()));
+    }
+
+    #[test]
+    fn test_output_rate() {
+        let mut stretch: Stretch<2> = StretchBuilder::new()
+            .preset_default(44100.0)
+            .transpose_semitones(3.0, None)
+            .output_rate(44100.0, 48000.0)
+            .build();
+        assert!((stretch.output_rate_ratio() - 48000.0 / 44100.0).abs() < 1e-6);
+
+        // 44.1 kHz in, 48 kHz out at the original speed
+        let input = vec![0.0f32; 441];
+        let mut left = vec![0.0f32; 480];
+        let mut right = vec![0.0f32; 480];
+        stretch.process([&input, &input], &mut [&mut left, &mut right]);
+
+        // The report counts the output latency in input samples
+        let report = stretch.latency_report(44100.0);
+        let output_latency = (stretch.output_latency() as f32 * (44100.0 / 48000.0)).round() as i32;
+        assert_eq!(report.latency_samples, stretch.input_latency() + output_latency);
+
+        stretch.set_output_rate(48000.0, 48000.0);
+        assert_eq!(stretch.output_rate_ratio(), 1.0);
+
+        // A tonality limit set before or after the rate change reaches the core the same
+        let tone: Vec<f32> = (0..4410).map(|i| (i as f32 * 0.05).sin() * 0.3).collect();
+        let render = |mut stretch: Stretch<1>| {
+            let mut output = vec![0.0f32; 4800];
+            stretch.process([&tone], &mut [&mut output]);
+            output
+        };
+        let built = StretchBuilder::with_seed(7)
+            .preset_default(44100.0)
+            .transpose_semitones(3.0, Some(0.1))
+            .output_rate(44100.0, 48000.0)
+            .build();
+        let mut set = Stretch::with_seed(7, 44100.0);
+        set.set_output_rate(44100.0, 48000.0);
+        set.set_transpose_semitones(3.0, Some(0.1));
+        assert_eq!(render(built), render(set));
+    }
+
+    #[test]
+    fn test_preset_for_latency() {
+        let stretch: Stretch<2> = StretchBuilder::new().preset_for_latency(48000.0, 20.0).build();
+        let report = stretch.latency_report(48000.0);
+        assert!(report.latency_ms <= 20.0);
+        // At most 960 samples, with the cheaper preset's overlap
+        assert!(report.block_samples <= 960);
+        assert_eq!(report.interval_samples, (report.block_samples as f32 * 0.4) as i32);
+        assert!(report.relative_cpu < 1.0);
+        assert!((latency::relative_cpu(48000.0, 5760, 1440) - 1.0).abs() < 1e-6);
+
+        // The selection rule: the chosen block fits, and the next FFT size up doesn't
+        let assert_longest_fit = |report: latency::LatencyReport, rate_ratio: f32, budget: i32| {
+            assert!(report.latency_samples <= budget);
+            let next = crate::memory::fft_size_above(report.block_samples as usize + 1) as i32;
+            let larger: Stretch<2> = StretchBuilder::new()
+                .configure(next, (next as f32 * 0.4) as i32)
+                .build();
+            let output_latency = (larger.output_latency() as f32 * rate_ratio).round() as i32;
+            assert!(larger.input_latency() + output_latency > budget);
+        };
+        assert_longest_fit(report, 1.0, 960);
+
+        // Halving the output rate doubles the output latency in input time, so a shorter
+        // block is chosen for the same budget
+        let stretch: Stretch<2> = StretchBuilder::new()
+            .output_rate(48000.0, 24000.0)
+            .preset_for_latency(48000.0, 20.0)
+            .build();
+        let halved = stretch.latency_report(48000.0);
+        assert!(halved.latency_ms <= 20.0);
+        assert!(halved.block_samples < report.block_samples);
+        assert_longest_fit(halved, 2.0, 960);
+    }
+
+    #[cfg(feature = "custom-allocator")]
+    #[test]
+    fn test_memory_usage_matches_allocations() {
+        // Live bytes held by the C++ object and its containers, against the model
+        for (block_samples, interval_samples) in [(5292, 1323), (4410, 1764), (1000, 250)] {
+            let allocator = StretchAllocator::new(std::alloc::System);
+            let before = CxxAllocations::now();
+            let stretch: Stretch<2> = StretchBuilder::new_in(allocator.clone())
+                .configure(block_samples, interval_samples)
+                .build();
+            let made = CxxAllocations::now().since(&before);
+            // Each routed block carries a 16-byte header recording its allocator
+            let measured = allocator.allocated_bytes() - 16 * allocator.allocation_count();
+            let predicted = stretch.memory_usage().total();
+            assert!(made.bytes as usize >= measured);
+            let error = (predicted as f64 - measured as f64).abs() / measured as f64;
+            assert!(
+                error < 0.05,
+                "{}/{}: predicted {} bytes, measured {}",
+                block_samples,
+                interval_samples,
+                predicted,
+                measured
+            );
+        }
+    }
+
+    #[cfg(any(target_arch = "x86_64", target_arch = "aarch64"))]
+    #[test]
+    fn test_denormal_guard_restores_state() {
+        let tiny = std::hint::black_box(1e-39f32);
+        {
+            let _guard = DenormalGuard::new();
+            assert_eq!(tiny * std::hint::black_box(0.5), 0.0);
+        }
+        assert!(tiny * std::hint::black_box(0.5) > 0.0);
+    }
+
+    #[test]
+    fn test_deadline_monitor() {
+        use std::sync::Arc;
+        use std::time::Duration;
+
+        let monitor = Arc::new(DeadlineMonitor::new(48000.0));
+        // 480 samples at 48 kHz: a 10 ms deadline
+        monitor.record(480, Duration::from_millis(1));
+        monitor.record(480, Duration::from_millis(20));
+        let snapshot = monitor.snapshot();
+        assert_eq!((snapshot.calls, snapshot.overruns), (2, 1));
+        assert!(snapshot.percentile(0.5) < Duration::from_micros(1100));
+        assert_eq!(snapshot.percentile(1.0), Duration::from_millis(20));
+
+        let mut stretch = StretchBuilder::<1>::new()
+            .preset_default(48000.0)
+            .monitor(monitor.clone())
+            .build();
+        let input = [0.5f32; 480];
+        let mut output = [0.0f32; 480];
+        stretch.process([&input[..]], &mut [&mut output[..]]);
+        assert_eq!(monitor.snapshot().calls, 3);
+    }
+
+    #[cfg(feature = "custom-allocator")]
+    #[test]
+    fn test_custom_allocator_receives_allocations() {
+        let allocator = StretchAllocator::new(std::alloc::System);
+        let stretch = Stretch::<2>::new_in(44100.0, allocator.clone());
+        assert!(allocator.allocated_bytes() > 0);
+        drop(stretch);
+        assert_eq!(allocator.allocation_count(), 0);
+    }
+
+    #[cfg(feature = "custom-allocator")]
+    #[test]
+    fn test_allocator_scopes_nest() {
+        let outer = StretchAllocator::new(std::alloc::System);
+        let inner = StretchAllocator::new(std::alloc::System);
+        let _scope = allocator::AllocatorScope::enter(Some(&outer));
+        let stretch = Stretch::<2>::new_in(44100.0, inner.clone());
+        assert!(inner.allocation_count() > 0);
+        // Leaving the stretcher's scope routes allocations back to the outer allocator
+        let before = outer.allocation_count();
+        let filter = BiquadFilter::new();
+        assert_eq!(outer.allocation_count(), before + 1);
+        drop(filter);
+        drop(stretch);
+        assert_eq!(inner.allocation_count(), 0);
+    }
+
     #[test]
     fn test_create_biquad() {
         let mut filter = BiquadFilter::new();
@@ -0,0 +1,133 @@
+use crate::sample::StretchSample;
+use std::mem::size_of;
+
+/// Approximate heap memory held by a stretcher, in bytes, grouped by purpose.
+///
+/// These figures model the allocations made by the C++ `configure()` from the block and
+/// interval sizes, so they can be computed before anything is allocated. A test with the
+/// `custom-allocator` feature checks the total against the live bytes of an instance
+/// allocating through a `StretchAllocator`, to within 5%.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MemoryUsage {
+    /// The C++ object itself (configuration, random engine, container headers).
+    pub object: usize,
+    /// Input history, overlap-add output and time-domain scratch buffers.
+    pub stft_buffers: usize,
+    /// Per-channel spectra, band state and phase predictions.
+    pub spectra: usize,
+    /// Peak list and the (smoothed) energy tables used to find peaks.
+    pub peak_tables: usize,
+    /// Output-to-input frequency map used for pitch shifting.
+    pub output_maps: usize,
+    /// FFT twiddles, working buffer and analysis window.
+    pub fft_plans: usize,
+}
+
+// Per-band state in the C++ core: input, previous input, output and previous output
+// (complex) plus the input energy.
+const BAND_SAMPLES: usize = 4 * 2 + 1;
+// Per-band phase prediction: energy plus a complex input.
+const PREDICTION_SAMPLES: usize = 1 + 2;
+// A detected peak: input and output frequency.
+const PEAK_SAMPLES: usize = 2;
+// An output map point: input bin and frequency gradient.
+const MAP_POINT_SAMPLES: usize = 2;
+
+impl MemoryUsage {
+    /// Predict the memory used by an `f32` stretcher configured with
+    /// `configure(block_samples, interval_samples)` for `channels` channels.
+    ///
+    /// Nothing is allocated, so this can be used before creating any instances.
+    pub fn predict(channels: usize, block_samples: i32, interval_samples: i32) -> Self {
+        Self::predict_for::<f32>(channels, block_samples, interval_samples)
+    }
+
+    /// Like `predict`, for a stretcher processing samples of type `T`.
+    pub fn predict_for<T: StretchSample>(
+        channels: usize,
+        block_samples: i32,
+        interval_samples: i32,
+    ) -> Self {
+        let object = T::core_object_size();
+        if channels == 0 || block_samples <= 0 {
+            return Self {
+                object,
+                ..Self::default()
+            };
+        }
+
+        let sample = size_of::<T>();
+        let complex = 2 * sample;
+        let block = block_samples as usize;
+        let interval = interval_samples.max(1) as usize;
+        let fft_size = fft_size_above(block);
+        let bands = fft_size / 2;
+
+        Self {
+            object,
+            // Input ring buffer, STFT overlap-add history and one FFT-sized scratch buffer
+            stft_buffers: (channels * (block + interval + 1)
+                + channels * (block + interval)
+                + fft_size)
+                * sample,
+            // STFT spectrum, band state and predictions per channel, plus two rotation tables
+            spectra: channels * bands * (complex + (BAND_SAMPLES + PREDICTION_SAMPLES) * sample)
+                + 2 * bands * complex,
+            // Peaks are reserved for half the bands; energy and smoothed energy are per band
+            peak_tables: (bands / 2) * PEAK_SAMPLES * sample + 2 * bands * sample,
+            output_maps: bands * MAP_POINT_SAMPLES * sample,
+            // Twiddle factors and a working buffer, plus the analysis window
+            fft_plans: 2 * fft_size * complex + block * sample,
+        }
+    }
+
+    /// Predict the memory used by a stretcher configured with `preset_default(sample_rate)`.
+    pub fn predict_preset_default(channels: usize, sample_rate: f32) -> Self {
+        // Mirrors SignalsmithStretch::presetDefault()
+        Self::predict(
+            channels,
+            (sample_rate * 0.12) as i32,
+            (sample_rate * 0.03) as i32,
+        )
+    }
+
+    /// Predict the memory used by a stretcher configured with `preset_cheaper(sample_rate)`.
+    pub fn predict_preset_cheaper(channels: usize, sample_rate: f32) -> Self {
+        // Mirrors SignalsmithStretch::presetCheaper()
+        Self::predict(
+            channels,
+            (sample_rate * 0.1) as i32,
+            (sample_rate * 0.04) as i32,
+        )
+    }
+
+    /// Total bytes across all categories.
+    pub fn total(&self) -> usize {
+        self.object
+            + self.stft_buffers
+            + self.spectra
+            + self.peak_tables
+            + self.output_maps
+            + self.fft_plans
+    }
+}
+
+/// Smallest FFT size at least `size` that the C++ FFT handles efficiently
+/// (a power of two, optionally times 3 or 5).
+pub(crate) fn fft_size_above(size: usize) -> usize {
+    let mut best = size.next_power_of_two();
+    for factor in [3, 5] {
+        best = best.min(factor * size.div_ceil(factor).next_power_of_two());
+    }
+    best
+}
+
+/// Largest efficient FFT size no greater than `size` (at least 1).
+pub(crate) fn fft_size_below(size: usize) -> usize {
+    let power_below = |n: usize| n.checked_ilog2().map_or(0, |log| 1 << log);
+    let mut best = power_below(size).max(1);
+    for factor in [3, 5] {
+        best = best.max(factor * power_below(size / factor));
+    }
+    best
+}
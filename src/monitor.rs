@@ -0,0 +1,188 @@
+//! Realtime health telemetry: per-call wall time against the audio deadline.
+//!
+//! Attach a `DeadlineMonitor` to a stretcher (`StretchBuilder::monitor` or
+//! `Stretch::set_monitor`) and every `process`/`flush` call is timed against the
+//! time its output represents (`output_samples / sample_rate`, optionally scaled by
+//! a budget fraction). Times go into an HDR-style log-linear histogram and calls over
+//! the deadline are counted. All counters are atomics, so an exporter thread can take
+//! a `MonitorSnapshot` at any time without blocking the audio thread.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Duration;
+
+// Sub-buckets per power of two: values are recorded to within 1/16 (~6%)
+const SUB_BITS: u32 = 4;
+const SUB_BUCKETS: usize = 1 << SUB_BITS;
+// Largest recorded time is 2^40 ns (~18 minutes); longer calls land in the last bucket
+const MAX_BITS: u32 = 40;
+const BUCKETS: usize = (MAX_BITS - SUB_BITS + 1) as usize * SUB_BUCKETS;
+
+/// Histogram bucket for a value in nanoseconds.
+fn bucket_index(nanos: u64) -> usize {
+    let nanos = nanos.min((1 << MAX_BITS) - 1);
+    if nanos < SUB_BUCKETS as u64 {
+        return nanos as usize;
+    }
+    let shift = nanos.ilog2() - SUB_BITS;
+    let sub = (nanos >> shift) as usize & (SUB_BUCKETS - 1);
+    (shift as usize + 1) * SUB_BUCKETS + sub
+}
+
+/// Smallest value in nanoseconds that falls in `index`.
+fn bucket_lower_bound(index: usize) -> u64 {
+    if index < SUB_BUCKETS {
+        return index as u64;
+    }
+    let shift = index / SUB_BUCKETS - 1;
+    ((SUB_BUCKETS + index % SUB_BUCKETS) as u64) << shift
+}
+
+/// Times processing calls against their realtime deadline.
+///
+/// Share one monitor (in an `Arc`) between a stretcher and the thread exporting its
+/// metrics, or between several stretchers to get a combined view.
+pub struct DeadlineMonitor {
+    sample_rate: f64,
+    budget: f64,
+    calls: AtomicU64,
+    overruns: AtomicU64,
+    total_nanos: AtomicU64,
+    max_nanos: AtomicU64,
+    // Worst elapsed/deadline ratio seen, in thousandths
+    max_load_permille: AtomicU64,
+    buckets: Box<[AtomicU64]>,
+}
+
+impl DeadlineMonitor {
+    /// A monitor for audio at `sample_rate`, with the whole callback period as deadline.
+    pub fn new(sample_rate: f64) -> Self {
+        Self {
+            sample_rate,
+            budget: 1.0,
+            calls: AtomicU64::new(0),
+            overruns: AtomicU64::new(0),
+            total_nanos: AtomicU64::new(0),
+            max_nanos: AtomicU64::new(0),
+            max_load_permille: AtomicU64::new(0),
+            buckets: (0..BUCKETS).map(|_| AtomicU64::new(0)).collect(),
+        }
+    }
+
+    /// Only allow `fraction` of the callback period (e.g. `0.5` when the stretcher
+    /// shares the callback with other processing).
+    pub fn with_budget(mut self, fraction: f64) -> Self {
+        self.budget = fraction;
+        self
+    }
+
+    /// The deadline for a call producing `output_samples` samples.
+    pub fn deadline(&self, output_samples: usize) -> Duration {
+        Duration::from_secs_f64(output_samples as f64 / self.sample_rate * self.budget)
+    }
+
+    /// Record a call that produced `output_samples` samples in `elapsed`.
+    pub fn record(&self, output_samples: usize, elapsed: Duration) {
+        let nanos = elapsed.as_nanos().min(u64::MAX as u128) as u64;
+        let deadline = self.deadline(output_samples).as_nanos() as u64;
+
+        self.calls.fetch_add(1, Ordering::Relaxed);
+        self.total_nanos.fetch_add(nanos, Ordering::Relaxed);
+        self.max_nanos.fetch_max(nanos, Ordering::Relaxed);
+        self.buckets[bucket_index(nanos)].fetch_add(1, Ordering::Relaxed);
+        if nanos > deadline {
+            self.overruns.fetch_add(1, Ordering::Relaxed);
+        }
+        if deadline > 0 {
+            let load = (nanos as u128 * 1000 / deadline as u128).min(u64::MAX as u128) as u64;
+            self.max_load_permille.fetch_max(load, Ordering::Relaxed);
+        }
+    }
+
+    /// Copy the current counters.
+    ///
+    /// Counters are read one at a time, so a snapshot taken during a call may count
+    /// it in some fields and not others.
+    pub fn snapshot(&self) -> MonitorSnapshot {
+        MonitorSnapshot {
+            calls: self.calls.load(Ordering::Relaxed),
+            overruns: self.overruns.load(Ordering::Relaxed),
+            total: Duration::from_nanos(self.total_nanos.load(Ordering::Relaxed)),
+            max: Duration::from_nanos(self.max_nanos.load(Ordering::Relaxed)),
+            max_load: self.max_load_permille.load(Ordering::Relaxed) as f64 / 1000.0,
+            buckets: self
+                .buckets
+                .iter()
+                .map(|bucket| bucket.load(Ordering::Relaxed))
+                .collect(),
+        }
+    }
+
+    /// Zero all counters.
+    pub fn reset(&self) {
+        self.calls.store(0, Ordering::Relaxed);
+        self.overruns.store(0, Ordering::Relaxed);
+        self.total_nanos.store(0, Ordering::Relaxed);
+        self.max_nanos.store(0, Ordering::Relaxed);
+        self.max_load_permille.store(0, Ordering::Relaxed);
+        for bucket in self.buckets.iter() {
+            bucket.store(0, Ordering::Relaxed);
+        }
+    }
+}
+
+/// A `DeadlineMonitor`'s counters at one point in time.
+#[derive(Debug, Clone, PartialEq)]
+pub struct MonitorSnapshot {
+    /// Calls recorded.
+    pub calls: u64,
+    /// Calls which took longer than their deadline.
+    pub overruns: u64,
+    /// Total time spent in recorded calls.
+    pub total: Duration,
+    /// Longest call.
+    pub max: Duration,
+    /// Worst ratio of call time to deadline (above 1.0 means an overrun).
+    pub max_load: f64,
+    buckets: Vec<u64>,
+}
+
+impl MonitorSnapshot {
+    /// Fraction of calls which overran (0 if nothing was recorded).
+    pub fn overrun_fraction(&self) -> f64 {
+        if self.calls == 0 {
+            0.0
+        } else {
+            self.overruns as f64 / self.calls as f64
+        }
+    }
+
+    /// Call time at quantile `q` (0.5 for the median, 0.999 for p99.9), accurate to
+    /// the histogram's resolution of about 6%.
+    pub fn percentile(&self, q: f64) -> Duration {
+        let total: u64 = self.buckets.iter().sum();
+        if total == 0 {
+            return Duration::ZERO;
+        }
+        let rank = ((q.clamp(0.0, 1.0) * total as f64).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (index, count) in self.buckets.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                // Upper edge of the bucket, but never more than the observed maximum
+                let upper = bucket_lower_bound(index + 1).saturating_sub(1);
+                return Duration::from_nanos(upper).min(self.max);
+            }
+        }
+        self.max
+    }
+
+    /// Non-empty histogram buckets as (lower bound, count), in increasing order.
+    pub fn histogram(&self) -> impl Iterator<Item = (Duration, u64)> + '_ {
+        self.buckets
+            .iter()
+            .enumerate()
+            .filter(|(_, count)| **count > 0)
+            .map(|(index, count)| (Duration::from_nanos(bucket_lower_bound(index)), *count))
+    }
+}
+
@@ -0,0 +1,706 @@
+//! Band-split stretching with a block size per band.
+//!
+//! One block size is a trade-off: long blocks resolve bass but smear transients in the
+//! highs, short blocks everywhere cost CPU. `MultibandStretch` splits the input with
+//! Linkwitz-Riley (4th-order) crossovers built from `BiquadFilter`s, stretches each band
+//! with its own block size, and sums the bands again:
+//!
+//! - lower bands get allpasses matching the phase of the crossovers above them, so the
+//!   bands sum to a flat magnitude response
+//! - a band may run its stretcher at a reduced sample rate (`BandConfig::decimation`),
+//!   which shrinks its FFTs; low-pass filters around the rate change keep it clean
+//! - the other bands get allpasses with the phase of those two low-passes, so the phase
+//!   of the rate change matches across bands too, not just its delay at 0 Hz
+//! - bands have different latencies (including the group delay of the rate-change
+//!   filters), so their input and output are delayed to line up with the slowest band
+//!
+//! The top band may be decimated too, which discards everything above the reduced rate's
+//! band edge. `MultibandStretch::high_rate` uses this for 88.2 to 192 kHz sessions: only
+//! the audible band is stretched, at 44.1 or 48 kHz, so the cost is close to that of a
+//! 48 kHz stretcher, and the output is back at the session rate.
+
+use crate::dsp::delay::Delay;
+use crate::dsp::filters::BiquadFilter;
+use crate::stretch::{Stretch, StretchBuilder};
+use crate::util::buffer::mix_into;
+use std::array;
+use std::f32::consts::{FRAC_1_SQRT_2, PI};
+
+// Sections of the (12th-order Butterworth) low-pass on each side of a rate change
+const RATE_CHANGE_SECTIONS: usize = 6;
+// Its cutoff, as a fraction of the reduced sample rate
+const RATE_CHANGE_CUTOFF: f32 = 0.45;
+
+/// Block timing and sample rate of one band of a `MultibandStretch`.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct BandConfig {
+    /// Block length in seconds.
+    pub block_seconds: f32,
+    /// Interval between blocks in seconds.
+    pub interval_seconds: f32,
+    /// Run the band's stretcher at `1 / decimation` of the sample rate (1 for none).
+    pub decimation: usize,
+}
+
+// Filter `samples` through each section of `chain` in turn
+fn run(chain: &mut [BiquadFilter], samples: &mut [f32]) {
+    for filter in chain {
+        filter.process_in_place(samples);
+    }
+}
+
+// One chain per channel, each section made by `design`
+fn chains<const C: usize>(
+    sections: usize,
+    design: impl Fn(usize, &mut BiquadFilter),
+) -> Vec<Vec<BiquadFilter>> {
+    (0..C)
+        .map(|_| {
+            (0..sections)
+                .map(|section| {
+                    let mut filter = BiquadFilter::new();
+                    design(section, &mut filter);
+                    filter
+                })
+                .collect()
+        })
+        .collect()
+}
+
+// Linkwitz-Riley 4th order: two identical Butterworth sections
+fn linkwitz_riley<const C: usize>(freq: f32, highpass: bool) -> Vec<Vec<BiquadFilter>> {
+    chains::<C>(2, |_, filter| {
+        if highpass {
+            filter.highpass(freq, FRAC_1_SQRT_2, None);
+        } else {
+            filter.lowpass(freq, FRAC_1_SQRT_2, None);
+        }
+    })
+}
+
+// Cutoff and Q of one section of the low-pass around a rate change by `decimation`
+fn rate_change_section(decimation: usize, section: usize) -> (f32, f32) {
+    let order = 2 * RATE_CHANGE_SECTIONS;
+    let q = 1.0 / (2.0 * ((2 * section + 1) as f32 * PI / (2 * order) as f32).cos());
+    (RATE_CHANGE_CUTOFF / decimation as f32, q)
+}
+
+// The low-pass around a rate change by `decimation`
+pub(crate) fn rate_change<const C: usize>(decimation: usize) -> Vec<Vec<BiquadFilter>> {
+    chains::<C>(RATE_CHANGE_SECTIONS, |section, filter| {
+        let (freq, q) = rate_change_section(decimation, section);
+        filter.lowpass(freq, q, None);
+    })
+}
+
+// Allpasses with the phase that the low-pass of a rate change by each of `decimations`
+// has once it has run twice (before and after the band's stretcher). A cookbook allpass
+// section has its low-pass section's poles and exactly twice its phase.
+pub(crate) fn rate_change_allpasses<const C: usize>(
+    decimations: &[usize],
+) -> Vec<Vec<BiquadFilter>> {
+    chains::<C>(
+        decimations.len() * RATE_CHANGE_SECTIONS,
+        |section, filter| {
+            let (freq, q) = rate_change_section(
+                decimations[section / RATE_CHANGE_SECTIONS],
+                section % RATE_CHANGE_SECTIONS,
+            );
+            filter.allpass(freq, q, None);
+        },
+    )
+}
+
+// Group delay at 0 Hz of the low-pass around a rate change, in (full-rate) samples
+fn rate_change_delay(decimation: usize) -> f32 {
+    // A cookbook low-pass delays by alpha / (1 - cos(w0)) samples at 0 Hz
+    (0..RATE_CHANGE_SECTIONS)
+        .map(|section| {
+            let (freq, q) = rate_change_section(decimation, section);
+            let w0 = 2.0 * PI * freq;
+            w0.sin() / (2.0 * q) / (1.0 - w0.cos())
+        })
+        .sum()
+}
+
+struct Crossover {
+    lowpass: Vec<Vec<BiquadFilter>>,
+    highpass: Vec<Vec<BiquadFilter>>,
+}
+
+struct Band<const C: usize> {
+    stretch: Stretch<C>,
+    decimation: usize,
+    // Per channel: an allpass for each crossover above this band's own
+    allpasses: Vec<Vec<BiquadFilter>>,
+    // Per channel, around the rate change (empty without decimation)
+    anti_alias: Vec<Vec<BiquadFilter>>,
+    interpolate: Vec<Vec<BiquadFilter>>,
+    // Per channel: allpasses matching the other bands' rate changes
+    rate_allpasses: Vec<Vec<BiquadFilter>>,
+    // Group delay of the filters on the input and output side, in full-rate samples
+    filter_delay: (usize, usize),
+    input_delay: usize,
+    output_delay: usize,
+    input_delays: Vec<Delay>,
+    output_delays: Vec<Delay>,
+    // Full-rate samples consumed and produced, for the decimation phase
+    consumed: usize,
+    produced: usize,
+}
+
+impl<const C: usize> Band<C> {
+    // Delay this band's part of the input and, if decimated, filter it and take the
+    // samples on the band's grid into `reduced`. Returns the stretcher's input channels
+    // and their length.
+    fn input(
+        &mut self,
+        split: &mut [Vec<f32>],
+        staged: &mut [f32],
+        reduced: &mut [Vec<f32>],
+        input_samples: usize,
+    ) -> ([*const f32; C], usize) {
+        for (channel, samples) in split.iter_mut().enumerate() {
+            run(
+                &mut self.rate_allpasses[channel],
+                &mut samples[..input_samples],
+            );
+        }
+        if self.input_delay > 0 {
+            for (channel, delay) in split.iter_mut().zip(&mut self.input_delays) {
+                let staged = &mut staged[..input_samples];
+                staged.copy_from_slice(&channel[..input_samples]);
+                delay.process_buffer(
+                    staged,
+                    &mut channel[..input_samples],
+                    self.input_delay as f32,
+                );
+            }
+        }
+        if self.decimation == 1 {
+            return (
+                array::from_fn(|channel| split[channel].as_ptr()),
+                input_samples,
+            );
+        }
+
+        let first = grid_start(self.consumed, self.decimation);
+        let reduced_samples = grid_count(first, input_samples, self.decimation);
+        for (channel, samples) in split.iter_mut().enumerate() {
+            let samples = &mut samples[..input_samples];
+            run(&mut self.anti_alias[channel], samples);
+            for (index, reduced) in reduced[channel][..reduced_samples].iter_mut().enumerate() {
+                *reduced = samples[first + index * self.decimation];
+            }
+        }
+        self.consumed += input_samples;
+        (
+            array::from_fn(|channel| reduced[channel].as_ptr()),
+            reduced_samples,
+        )
+    }
+
+    // Bring `reduced_samples` of the stretcher's output in `reduced` back to the full
+    // rate in `output` (`output_samples` long), then delay it
+    fn output(
+        &mut self,
+        reduced: &[Vec<f32>],
+        output: &mut [Vec<f32>],
+        staged: &mut [f32],
+        output_samples: usize,
+    ) {
+        if self.decimation > 1 {
+            let first = grid_start(self.produced, self.decimation);
+            for (channel, samples) in output.iter_mut().enumerate() {
+                let samples = &mut samples[..output_samples];
+                samples.fill(0.0);
+                let reduced_samples = grid_count(first, output_samples, self.decimation);
+                for (index, reduced) in reduced[channel][..reduced_samples].iter().enumerate() {
+                    // Zero-stuffing divides the level by the decimation factor
+                    samples[first + index * self.decimation] = reduced * self.decimation as f32;
+                }
+                run(&mut self.interpolate[channel], samples);
+            }
+            self.produced += output_samples;
+        }
+        if self.output_delay > 0 {
+            for (channel, delay) in output.iter_mut().zip(&mut self.output_delays) {
+                let staged = &mut staged[..output_samples];
+                staged.copy_from_slice(&channel[..output_samples]);
+                delay.process_buffer(
+                    staged,
+                    &mut channel[..output_samples],
+                    self.output_delay as f32,
+                );
+            }
+        }
+    }
+}
+
+// First index of a call on a decimation grid, `done` full-rate samples in
+fn grid_start(done: usize, decimation: usize) -> usize {
+    (decimation - done % decimation) % decimation
+}
+
+// Grid points among `samples` full-rate samples, starting at `first`
+fn grid_count(first: usize, samples: usize, decimation: usize) -> usize {
+    if first < samples {
+        (samples - first - 1) / decimation + 1
+    } else {
+        0
+    }
+}
+
+/// A stretcher running each frequency band with its own block size. See the module
+/// documentation.
+pub struct MultibandStretch<const C: usize> {
+    crossovers: Vec<Crossover>,
+    bands: Vec<Band<C>>,
+    input_latency: usize,
+    output_latency: usize,
+    // Input samples per output sample in the last call, for `flush`
+    rate: f64,
+    // Scratch, grown to the longest call so far
+    rest: Vec<Vec<f32>>,
+    split: Vec<Vec<Vec<f32>>>,
+    staged: Vec<f32>,
+    reduced_input: Vec<Vec<f32>>,
+    reduced_output: Vec<Vec<f32>>,
+    band_output: Vec<Vec<f32>>,
+    // Input for `flush`
+    silence: Vec<f32>,
+}
+
+impl<const C: usize> MultibandStretch<C> {
+    /// Split at `crossovers_hz` (ascending) into bands configured by `bands`, from the
+    /// lowest up.
+    ///
+    /// # Panics
+    ///
+    /// Panics if there isn't one more band than crossovers, the crossovers aren't
+    /// ascending below Nyquist, a decimated band's upper crossover is above 1/8 of its
+    /// reduced sample rate, or a decimated top band's lower crossover is above 1/4 of it.
+    pub fn new(sample_rate: f32, crossovers_hz: &[f32], bands: &[BandConfig]) -> Self {
+        assert_eq!(
+            bands.len(),
+            crossovers_hz.len() + 1,
+            "expected one more band than crossovers"
+        );
+        assert!(
+            crossovers_hz.windows(2).all(|pair| pair[0] < pair[1])
+                && crossovers_hz
+                    .iter()
+                    .all(|&freq| freq > 0.0 && freq < sample_rate / 2.0),
+            "crossovers must ascend between 0 Hz and Nyquist"
+        );
+        let crossovers_normalized: Vec<f32> = crossovers_hz
+            .iter()
+            .map(|freq| freq / sample_rate)
+            .collect();
+
+        let crossovers = crossovers_normalized
+            .iter()
+            .map(|&freq| Crossover {
+                lowpass: linkwitz_riley::<C>(freq, false),
+                highpass: linkwitz_riley::<C>(freq, true),
+            })
+            .collect();
+
+        let mut rate_changes: Vec<usize> = bands
+            .iter()
+            .map(|config| config.decimation)
+            .filter(|&decimation| decimation > 1)
+            .collect();
+        rate_changes.sort_unstable();
+        rate_changes.dedup();
+
+        let mut bands: Vec<Band<C>> = bands
+            .iter()
+            .enumerate()
+            .map(|(index, config)| {
+                let decimation = config.decimation.max(1);
+                if decimation > 1 {
+                    // The top band's upper edge is the rate-change filter itself
+                    let (edge, limit) = match crossovers_normalized.get(index) {
+                        Some(&upper) => (upper, 0.125),
+                        None => (
+                            index
+                                .checked_sub(1)
+                                .map_or(0.0, |i| crossovers_normalized[i]),
+                            0.25,
+                        ),
+                    };
+                    assert!(
+                        edge * decimation as f32 <= limit,
+                        "band {} is decimated too far for its crossovers",
+                        index
+                    );
+                }
+                let rate = sample_rate / decimation as f32;
+                let stretch = StretchBuilder::new()
+                    .configure(
+                        (config.block_seconds * rate).round().max(1.0) as i32,
+                        (config.interval_seconds * rate).round().max(1.0) as i32,
+                    )
+                    .build();
+                let above = crossovers_normalized.get(index + 1..).unwrap_or(&[]);
+                let (anti_alias, interpolate) = if decimation > 1 {
+                    (rate_change::<C>(decimation), rate_change::<C>(decimation))
+                } else {
+                    (Vec::new(), Vec::new())
+                };
+                // A rate change's allpass sits on the input side with twice its low-pass's
+                // delay, where the band changing rate has half of it on either side
+                let others: Vec<usize> = rate_changes
+                    .iter()
+                    .copied()
+                    .filter(|&other| other != decimation)
+                    .collect();
+                let own_delay = if decimation > 1 {
+                    rate_change_delay(decimation)
+                } else {
+                    0.0
+                };
+                let others_delay: f32 = others.iter().map(|&other| rate_change_delay(other)).sum();
+                let filter_delay = (
+                    (own_delay + 2.0 * others_delay).round() as usize,
+                    own_delay.round() as usize,
+                );
+                Band {
+                    stretch,
+                    decimation,
+                    allpasses: chains::<C>(above.len(), |section, filter| {
+                        filter.allpass(above[section], FRAC_1_SQRT_2, None);
+                    }),
+                    anti_alias,
+                    interpolate,
+                    rate_allpasses: rate_change_allpasses::<C>(&others),
+                    filter_delay,
+                    input_delay: 0,
+                    output_delay: 0,
+                    input_delays: Vec::new(),
+                    output_delays: Vec::new(),
+                    consumed: 0,
+                    produced: 0,
+                }
+            })
+            .collect();
+
+        // Delay every band to the slowest one's latency, at the full sample rate
+        let latency = |band: &Band<C>| {
+            (
+                band.stretch.input_latency().max(0) as usize * band.decimation
+                    + band.filter_delay.0,
+                band.stretch.output_latency().max(0) as usize * band.decimation
+                    + band.filter_delay.1,
+            )
+        };
+        let input_latency = bands.iter().map(|band| latency(band).0).max().unwrap_or(0);
+        let output_latency = bands.iter().map(|band| latency(band).1).max().unwrap_or(0);
+        for band in &mut bands {
+            let (input, output) = latency(band);
+            band.input_delay = input_latency - input;
+            band.output_delay = output_latency - output;
+        }
+
+        let mut stretch = Self {
+            crossovers,
+            bands,
+            input_latency,
+            output_latency,
+            rate: 1.0,
+            rest: vec![Vec::new(); C],
+            split: Vec::new(),
+            staged: Vec::new(),
+            reduced_input: vec![Vec::new(); C],
+            reduced_output: vec![Vec::new(); C],
+            band_output: vec![Vec::new(); C],
+            silence: Vec::new(),
+        };
+        stretch.split = (0..stretch.bands.len())
+            .map(|_| vec![Vec::new(); C])
+            .collect();
+        stretch.reset_delays();
+        stretch
+    }
+
+    /// Two bands split at `crossover_hz`: the low band with long blocks at a reduced
+    /// sample rate, the high band with short blocks for sharper transients.
+    pub fn two_band(sample_rate: f32, crossover_hz: f32) -> Self {
+        // Largest power of two keeping the crossover below 1/8 of the reduced rate
+        let mut decimation = 1;
+        while crossover_hz * (decimation * 2) as f32 <= sample_rate * 0.125 {
+            decimation *= 2;
+        }
+        Self::new(
+            sample_rate,
+            &[crossover_hz],
+            &[
+                BandConfig {
+                    block_seconds: 0.12,
+                    interval_seconds: 0.03,
+                    decimation,
+                },
+                BandConfig {
+                    block_seconds: 0.04,
+                    interval_seconds: 0.01,
+                    decimation: 1,
+                },
+            ],
+        )
+    }
+
+    /// Stretch only the audible band of a high-rate (88.2 to 192 kHz) signal, at the
+    /// largest power-of-two reduction keeping at least 44.1 kHz, with the default
+    /// preset's timing. Content above about 20 kHz is discarded. At 48 kHz and below
+    /// this is a single full-rate band.
+    pub fn high_rate(sample_rate: f32) -> Self {
+        let mut decimation = 1;
+        while sample_rate / (decimation * 2) as f32 >= 44_100.0 {
+            decimation *= 2;
+        }
+        Self::new(
+            sample_rate,
+            &[],
+            &[BandConfig {
+                block_seconds: 0.12,
+                interval_seconds: 0.03,
+                decimation,
+            }],
+        )
+    }
+
+    /// Number of bands.
+    pub fn bands(&self) -> usize {
+        self.bands.len()
+    }
+
+    /// The stretcher of one band (running at its reduced rate, if decimated).
+    pub fn band(&self, band: usize) -> &Stretch<C> {
+        &self.bands[band].stretch
+    }
+
+    /// Input latency in samples at the full rate, the same for every band.
+    pub fn input_latency(&self) -> usize {
+        self.input_latency
+    }
+
+    /// Output latency in samples at the full rate, the same for every band.
+    pub fn output_latency(&self) -> usize {
+        self.output_latency
+    }
+
+    /// Set every band's frequency multiplier; `tonality_limit` is a fraction of the full
+    /// sample rate, as for `Stretch`.
+    pub fn set_transpose_factor(&mut self, multiplier: f32, tonality_limit: Option<f32>) {
+        for band in &mut self.bands {
+            let limit = tonality_limit.map(|limit| limit * band.decimation as f32);
+            band.stretch.set_transpose_factor(multiplier, limit);
+        }
+    }
+
+    /// Set every band's shift in semitones (see `set_transpose_factor`).
+    pub fn set_transpose_semitones(&mut self, semitones: f32, tonality_limit: Option<f32>) {
+        self.set_transpose_factor(2f32.powf(semitones / 12.0), tonality_limit);
+    }
+
+    /// Reset every band's stretcher, filters and delays.
+    pub fn reset(&mut self) {
+        for crossover in &mut self.crossovers {
+            for filter in crossover
+                .lowpass
+                .iter_mut()
+                .chain(&mut crossover.highpass)
+                .flatten()
+            {
+                filter.reset();
+            }
+        }
+        for band in &mut self.bands {
+            band.stretch.reset();
+            for filter in band
+                .allpasses
+                .iter_mut()
+                .chain(&mut band.anti_alias)
+                .chain(&mut band.interpolate)
+                .chain(&mut band.rate_allpasses)
+                .flatten()
+            {
+                filter.reset();
+            }
+            band.consumed = 0;
+            band.produced = 0;
+        }
+        self.rate = 1.0;
+        self.reset_delays();
+    }
+
+    fn reset_delays(&mut self) {
+        for band in &mut self.bands {
+            band.input_delays = (0..C)
+                .map(|_| Delay::new(band.input_delay as i32))
+                .collect();
+            band.output_delays = (0..C)
+                .map(|_| Delay::new(band.output_delay as i32))
+                .collect();
+        }
+    }
+
+    /// Make room for calls of up to `input_samples` in and `output_samples` out, so
+    /// `process` never allocates.
+    pub fn reserve(&mut self, input_samples: usize, output_samples: usize) {
+        let grow = |buffer: &mut Vec<f32>, samples: usize| {
+            if buffer.len() < samples {
+                buffer.resize(samples, 0.0);
+            }
+        };
+        for channel in self.rest.iter_mut().chain(self.split.iter_mut().flatten()) {
+            grow(channel, input_samples);
+        }
+        grow(&mut self.staged, input_samples.max(output_samples));
+        for channel in &mut self.reduced_input {
+            grow(channel, input_samples);
+        }
+        for channel in self.reduced_output.iter_mut().chain(&mut self.band_output) {
+            grow(channel, output_samples);
+        }
+    }
+
+    /// Stretch `input` into `output`; the ratio is given by their lengths.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the input channels or output channels vary in length.
+    pub fn process(&mut self, input: [&[f32]; C], output: &mut [&mut [f32]; C]) {
+        let input_samples = input[0].len();
+        let output_samples = output[0].len();
+        assert!(
+            output.iter().all(|channel| channel.len() == output_samples),
+            "output channels vary in buffer length"
+        );
+        self.split(input);
+        self.reserve(input_samples, output_samples);
+        if input_samples > 0 && output_samples > 0 {
+            self.rate = input_samples as f64 / output_samples as f64;
+        }
+
+        for channel in output.iter_mut() {
+            channel.fill(0.0);
+        }
+        for (band, split) in self.bands.iter_mut().zip(&mut self.split) {
+            let (input_ptrs, reduced_in) = band.input(
+                split,
+                &mut self.staged,
+                &mut self.reduced_input,
+                input_samples,
+            );
+            let (stretched, reduced_out) = if band.decimation == 1 {
+                (&mut self.band_output, output_samples)
+            } else {
+                let first = grid_start(band.produced, band.decimation);
+                let reduced_out = grid_count(first, output_samples, band.decimation);
+                (&mut self.reduced_output, reduced_out)
+            };
+            let mut output_ptrs: [*mut f32; C] =
+                array::from_fn(|channel| stretched[channel].as_mut_ptr());
+            unsafe {
+                band.stretch.process_raw(
+                    input_ptrs.as_ptr(),
+                    reduced_in as i32,
+                    output_ptrs.as_mut_ptr(),
+                    reduced_out as i32,
+                );
+            }
+            band.output(
+                &self.reduced_output,
+                &mut self.band_output,
+                &mut self.staged,
+                output_samples,
+            );
+            for (samples, band_output) in output.iter_mut().zip(&self.band_output) {
+                mix_into(samples, &band_output[..output_samples], 1.0);
+            }
+        }
+    }
+
+    /// Provide previous input ("pre-roll"), as `Stretch::seek`: it runs through the
+    /// crossovers, each band's input delay and decimation into the band's `seek`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the input channels vary in length.
+    pub fn seek(&mut self, input: [&[f32]; C], playback_rate: f64) {
+        let input_samples = input[0].len();
+        self.split(input);
+        self.reserve(input_samples, 0);
+        if playback_rate > 0.0 {
+            self.rate = playback_rate;
+        }
+        for (band, split) in self.bands.iter_mut().zip(&mut self.split) {
+            let (input_ptrs, reduced_in) = band.input(
+                split,
+                &mut self.staged,
+                &mut self.reduced_input,
+                input_samples,
+            );
+            band.stretch
+                .seek_raw(input_ptrs.as_ptr(), reduced_in as i32, playback_rate);
+        }
+    }
+
+    /// Play out the remaining output into `output`, as `Stretch::flush`.
+    ///
+    /// Bands hold different amounts of input and output in their delays, so rather than
+    /// flushing each stretcher separately, silence is run through every band (crossovers,
+    /// delays, decimation and interpolation) at the last call's rate; that drains them
+    /// all in step and keeps the bands aligned.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the output channels vary in length.
+    pub fn flush(&mut self, output: &mut [&mut [f32]; C]) {
+        let input_samples = (output[0].len() as f64 * self.rate).round() as usize;
+        let mut silence = std::mem::take(&mut self.silence);
+        if silence.len() < input_samples {
+            silence.resize(input_samples, 0.0);
+        }
+        self.process([&silence[..input_samples]; C], output);
+        self.silence = silence;
+    }
+
+    // Split `input` into the bands' buffers: each crossover takes its low band off what
+    // is left above the previous one, and lower bands get the allpasses of the
+    // crossovers above them
+    pub(crate) fn split(&mut self, input: [&[f32]; C]) -> &[Vec<Vec<f32>>] {
+        let input_samples = input[0].len();
+        assert!(
+            input.iter().all(|channel| channel.len() == input_samples),
+            "input channels vary in sample length"
+        );
+        self.reserve(input_samples, 0);
+        for (channel, samples) in input.iter().enumerate() {
+            self.rest[channel][..input_samples].copy_from_slice(samples);
+        }
+        for (index, crossover) in self.crossovers.iter_mut().enumerate() {
+            for channel in 0..C {
+                let rest = &mut self.rest[channel][..input_samples];
+                let low = &mut self.split[index][channel][..input_samples];
+                low.copy_from_slice(rest);
+                run(&mut crossover.lowpass[channel], low);
+                run(&mut crossover.highpass[channel], rest);
+                for below in 0..index {
+                    run(
+                        &mut self.bands[below].allpasses[channel][index - below - 1..index - below],
+                        &mut self.split[below][channel][..input_samples],
+                    );
+                }
+            }
+        }
+        let top = self.bands.len() - 1;
+        for channel in 0..C {
+            self.split[top][channel][..input_samples]
+                .copy_from_slice(&self.rest[channel][..input_samples]);
+        }
+        &self.split
+    }
+}
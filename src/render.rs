@@ -0,0 +1,417 @@
+//! Parallel offline rendering of one long input.
+//!
+//! A single `Stretch` processes a file on one core. `ParallelRender` instead cuts the
+//! input into segments and stretches them concurrently on separate instances:
+//!
+//! - each segment is primed with `seek()` on the input before it (at least one block),
+//!   so it starts in the same steady state a single instance would be in
+//! - each segment renders past its end by an overlap, and neighbouring segments are
+//!   crossfaded there
+//! - independent instances make different phase decisions, so before each crossfade
+//!   the whole incoming segment is shifted to best line up with the outgoing one, and
+//!   the fade law follows their correlation (equal-gain when they are coherent,
+//!   equal-power when they are not), avoiding dips and comb filtering. Shifting the
+//!   whole segment rather than just its head keeps both sides of each fade continuous;
+//!   every segment stays within `max_shift_seconds` of the input's timing
+//!
+//! The trade-off: every segment costs an extra block of pre-roll plus the overlap, so
+//! shorter segments parallelise better but waste more work, and every boundary is a
+//! crossfade between two slightly different renders. With segments of tens of seconds
+//! the overhead is a few percent and the boundaries are very hard to hear; longer
+//! crossfades smooth them further at the cost of a longer blend of two renders.
+
+use crate::stretch::Stretch;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+use std::thread;
+
+/// Renders a long input on several threads. See the module documentation.
+#[derive(Debug, Clone)]
+pub struct ParallelRender {
+    sample_rate: f32,
+    threads: usize,
+    segment_seconds: Option<f32>,
+    crossfade_seconds: f32,
+    max_shift_seconds: f32,
+}
+
+/// One segment's output region, plus what it renders around the region's start (`head`)
+/// and end (`tail`), each window starting `max_shift` samples before that edge.
+struct Segment<'a, const C: usize> {
+    output: [&'a mut [f32]; C],
+    head: Vec<Vec<f32>>,
+    tail: Vec<Vec<f32>>,
+}
+
+impl<const C: usize> Segment<'_, C> {
+    /// Move the segment's output by `shift` samples (reading `shift` samples later),
+    /// filling the edges from the head and tail windows.
+    fn shift(&mut self, shift: isize, max_shift: usize) {
+        let amount = shift.unsigned_abs();
+        for ((region, head), tail) in self.output.iter_mut().zip(&self.head).zip(&self.tail) {
+            let length = region.len();
+            let moved = length.saturating_sub(amount);
+            if shift > 0 {
+                region.copy_within(amount.min(length).., 0);
+                region[moved..].copy_from_slice(&tail[max_shift..max_shift + length - moved]);
+            } else if shift < 0 {
+                region.copy_within(..moved, length - moved);
+                let filled = length - moved;
+                region[..filled].copy_from_slice(&head[max_shift - amount..][..filled]);
+            }
+        }
+    }
+}
+
+impl ParallelRender {
+    /// Render audio at `sample_rate` on all available cores.
+    pub fn new(sample_rate: f32) -> Self {
+        Self {
+            sample_rate,
+            threads: thread::available_parallelism().map_or(1, |n| n.get()),
+            segment_seconds: None,
+            crossfade_seconds: 0.05,
+            max_shift_seconds: 0.002,
+        }
+    }
+
+    /// Use `threads` worker threads.
+    pub fn threads(mut self, threads: usize) -> Self {
+        self.threads = threads.max(1);
+        self
+    }
+
+    /// Cut the input into segments of this many seconds. By default there are about
+    /// four segments per thread, each at least 16 blocks long.
+    pub fn segment_seconds(mut self, seconds: f32) -> Self {
+        self.segment_seconds = Some(seconds);
+        self
+    }
+
+    /// Length of the crossfade between segments (50 ms by default).
+    pub fn crossfade_seconds(mut self, seconds: f32) -> Self {
+        self.crossfade_seconds = seconds;
+        self
+    }
+
+    /// Largest shift of a segment from the input's timing, used to line it up with the
+    /// segment before it (2 ms by default; 0 disables the alignment).
+    pub fn max_shift_seconds(mut self, seconds: f32) -> Self {
+        self.max_shift_seconds = seconds;
+        self
+    }
+
+    /// Stretch `input` by `ratio` (output length / input length).
+    ///
+    /// `make` creates the stretcher for each segment, so it decides the preset,
+    /// transpose and so on; every call must configure it the same way.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the input channels have different lengths or `ratio` isn't positive.
+    pub fn render<const C: usize, F>(
+        &self,
+        input: [&[f32]; C],
+        ratio: f64,
+        make: F,
+    ) -> Vec<Vec<f32>>
+    where
+        F: Fn() -> Stretch<C> + Sync,
+    {
+        let length = input[0].len();
+        assert!(
+            input.iter().all(|channel| channel.len() == length),
+            "input channels vary in sample length"
+        );
+        assert!(ratio > 0.0, "ratio must be positive");
+        if length == 0 {
+            return vec![Vec::new(); C];
+        }
+        let _span = span!(
+            DEBUG,
+            "parallel_render",
+            channels = C,
+            samples_in = length,
+            ratio,
+            threads = self.threads
+        );
+
+        let probe = make();
+        let block = probe.block_samples().max(1) as usize;
+        let output_latency = probe.output_latency().max(0) as usize;
+        drop(probe);
+
+        let seconds = |seconds: f32| (seconds * self.sample_rate).max(0.0) as usize;
+        let crossfade = seconds(self.crossfade_seconds).max(1);
+        let max_shift = seconds(self.max_shift_seconds);
+        let segment = match self.segment_seconds {
+            Some(segment_seconds) => seconds(segment_seconds),
+            None => length.div_ceil(4 * self.threads),
+        }
+        .max(16 * block);
+
+        // Rendered past each segment's end: the crossfade and shift search, then enough
+        // that flush()'s wind-down at the very end stays out of it. Segments after the
+        // first also start early enough to be shifted back by up to max_shift.
+        let overlap_out =
+            crossfade + 2 * max_shift + output_latency + (block as f64 * ratio) as usize;
+        let overlap = (overlap_out as f64 / ratio).ceil() as usize;
+        let lead = if max_shift > 0 {
+            (max_shift as f64 / ratio).ceil() as usize + 1
+        } else {
+            0
+        };
+        let window = crossfade + 2 * max_shift;
+
+        let out_length = (length as f64 * ratio).round() as usize;
+        let boundaries: Vec<usize> = (0..length).step_by(segment).chain([length]).collect();
+        let out_boundaries: Vec<usize> = boundaries
+            .iter()
+            .map(|&b| ((b as f64 * ratio).round() as usize).min(out_length))
+            .collect();
+        let segments = boundaries.len() - 1;
+
+        let mut output = vec![vec![0.0f32; out_length]; C];
+        {
+            // Hand every segment its own disjoint region of the output
+            let mut regions: Vec<Vec<&mut [f32]>> =
+                (0..segments).map(|_| Vec::with_capacity(C)).collect();
+            for channel in output.iter_mut() {
+                let mut rest = &mut channel[..];
+                for (index, region) in regions.iter_mut().enumerate() {
+                    let (head, tail) =
+                        rest.split_at_mut(out_boundaries[index + 1] - out_boundaries[index]);
+                    region.push(head);
+                    rest = tail;
+                }
+            }
+            let slots: Vec<Mutex<Option<Segment<C>>>> = regions
+                .into_iter()
+                .map(|region| {
+                    let mut region = region.into_iter();
+                    Mutex::new(Some(Segment {
+                        output: std::array::from_fn(|_| region.next().unwrap()),
+                        head: Vec::new(),
+                        tail: Vec::new(),
+                    }))
+                })
+                .collect();
+
+            let next = AtomicUsize::new(0);
+            thread::scope(|scope| {
+                for _ in 0..self.threads.min(segments) {
+                    scope.spawn(|| {
+                        let mut stretch = make();
+                        loop {
+                            let index = next.fetch_add(1, Ordering::Relaxed);
+                            if index >= segments {
+                                break;
+                            }
+                            let mut slot = slots[index].lock().unwrap();
+                            let segment = slot.as_mut().unwrap();
+                            let start = boundaries[index].saturating_sub(lead);
+                            // Zero-padded past the end of the input
+                            let end = boundaries[index + 1] + overlap;
+                            let _span = span!(
+                                DEBUG,
+                                "render_segment",
+                                segment = index,
+                                samples_in = end - start
+                            );
+                            render_segment(
+                                &mut stretch,
+                                input,
+                                ratio,
+                                (start, end),
+                                block,
+                                segment,
+                                (out_boundaries[index], out_boundaries[index + 1]),
+                                max_shift,
+                                window,
+                            );
+                        }
+                    });
+                }
+            });
+
+            // Line each segment up with the one before it, then blend that one's tail
+            // into its start
+            let mut rendered: Vec<Segment<C>> = slots
+                .into_iter()
+                .map(|slot| slot.into_inner().unwrap().unwrap())
+                .collect();
+            let mut shift = 0isize;
+            for index in 1..segments {
+                let (done, rest) = rendered.split_at_mut(index);
+                let incoming = &mut rest[0];
+                let fade = crossfade.min(incoming.output[0].len());
+                let outgoing: Vec<&[f32]> = done[index - 1]
+                    .tail
+                    .iter()
+                    .map(|channel| &channel[(max_shift as isize + shift) as usize..][..fade])
+                    .collect();
+                let (next, rho) = align(&outgoing, &incoming.head, max_shift);
+                incoming.shift(next, max_shift);
+                crossfade_into(&mut incoming.output, &outgoing, rho);
+                shift = next;
+            }
+        }
+        output
+    }
+
+    /// Stretch several multichannel stems with one stretcher per segment, so they share
+    /// its analysis and stay phase-coherent (see [`LinkedStems`]).
+    ///
+    /// `make` builds a stretcher for all the stems' channels together (`C` in total),
+    /// and the result has the same stem layout as `stems`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the stems don't have `C` channels in total, or as `render`.
+    ///
+    /// [`LinkedStems`]: crate::stems::LinkedStems
+    pub fn render_stems<const C: usize, F>(
+        &self,
+        stems: &[Vec<Vec<f32>>],
+        ratio: f64,
+        make: F,
+    ) -> Vec<Vec<Vec<f32>>>
+    where
+        F: Fn() -> Stretch<C> + Sync,
+    {
+        assert_eq!(
+            stems.iter().map(Vec::len).sum::<usize>(),
+            C,
+            "stem channel counts must add up to the stretcher's {} channels",
+            C
+        );
+        let mut channels = stems.iter().flatten();
+        let input: [&[f32]; C] = std::array::from_fn(|_| &channels.next().unwrap()[..]);
+        let mut rendered = self.render(input, ratio, make).into_iter();
+        stems
+            .iter()
+            .map(|stem| rendered.by_ref().take(stem.len()).collect())
+            .collect()
+    }
+}
+
+/// Stretch input `range` into a segment's output region `[out_start, out_end)`, keeping
+/// `window` samples from `max_shift` before each end of the region as its head and tail.
+#[allow(clippy::too_many_arguments)]
+fn render_segment<const C: usize>(
+    stretch: &mut Stretch<C>,
+    input: [&[f32]; C],
+    ratio: f64,
+    (start, end): (usize, usize),
+    block: usize,
+    segment: &mut Segment<'_, C>,
+    (out_start, out_end): (usize, usize),
+    max_shift: usize,
+    window: usize,
+) {
+    stretch.reset();
+    let length = input[0].len();
+    let input_latency = stretch.input_latency().max(0) as usize;
+    let output_latency = stretch.output_latency().max(0) as usize;
+
+    // Prime with the preceding input (plus the latency look-ahead) so the segment starts
+    // in steady state, then process the rest, zero-padded past the end of the input
+    let preroll = start.saturating_sub(block);
+    let ahead = (start + input_latency).min(end).min(length);
+    if start > 0 {
+        stretch.seek(
+            std::array::from_fn(|c| &input[c][preroll..ahead]),
+            1.0 / ratio,
+        );
+    } else {
+        stretch.seek(std::array::from_fn(|c| &input[c][..ahead]), 1.0 / ratio);
+    }
+    let padded: Vec<Vec<f32>> = input
+        .iter()
+        .map(|channel| {
+            let mut samples = channel[ahead..end.min(length)].to_vec();
+            samples.resize(end - ahead, 0.0);
+            samples
+        })
+        .collect();
+
+    let out_samples = ((end - start) as f64 * ratio).round() as usize;
+    let mut rendered = vec![vec![0.0f32; out_samples.max(output_latency)]; C];
+    let processed = out_samples.saturating_sub(output_latency);
+    {
+        let mut outputs: [&mut [f32]; C] = {
+            let mut channels = rendered.iter_mut();
+            std::array::from_fn(|_| &mut channels.next().unwrap()[..processed])
+        };
+        stretch.process(std::array::from_fn(|c| &padded[c][..]), &mut outputs);
+    }
+    {
+        let outputs: [&mut [f32]; C] = {
+            let mut channels = rendered.iter_mut();
+            std::array::from_fn(|_| {
+                &mut channels.next().unwrap()[processed..processed + output_latency]
+            })
+        };
+        stretch.flush(outputs);
+    }
+
+    // Output position of rendered[0]; anything outside what was rendered reads as silence
+    let origin = (start as f64 * ratio).round() as usize;
+    let copy = |channel: &[f32], from: usize, samples: &mut [f32]| {
+        for (position, sample) in (from..).zip(samples.iter_mut()) {
+            *sample = position
+                .checked_sub(origin)
+                .and_then(|index| channel.get(index))
+                .copied()
+                .unwrap_or(0.0);
+        }
+    };
+    let mut head = vec![vec![0.0f32; window]; C];
+    let mut tail = vec![vec![0.0f32; window]; C];
+    for (channel, samples) in segment.output.iter_mut().enumerate() {
+        copy(&rendered[channel], out_start, samples);
+        copy(&rendered[channel], out_start.saturating_sub(max_shift), &mut head[channel]);
+        copy(&rendered[channel], out_end - max_shift.min(out_end), &mut tail[channel]);
+    }
+    segment.head = head;
+    segment.tail = tail;
+}
+
+/// The shift (within `max_shift`) which best lines the incoming segment's `head` up with
+/// `outgoing`, and their correlation at that shift.
+fn align(outgoing: &[&[f32]], head: &[Vec<f32>], max_shift: usize) -> (isize, f64) {
+    let fade = outgoing.first().map_or(0, |channel| channel.len());
+    let correlation = |shift: isize| -> (f64, f64) {
+        let offset = (max_shift as isize + shift) as usize;
+        let (mut cross, mut in_energy, mut out_energy) = (0.0, 0.0, 0.0);
+        for (outgoing, head) in outgoing.iter().zip(head) {
+            for (a, b) in head[offset..offset + fade].iter().zip(outgoing.iter()) {
+                cross += (*a as f64) * (*b as f64);
+                in_energy += (*a as f64) * (*a as f64);
+                out_energy += (*b as f64) * (*b as f64);
+            }
+        }
+        let norm = (in_energy * out_energy).sqrt();
+        (cross, if norm > 0.0 { cross / norm } else { 0.0 })
+    };
+    let max_shift = max_shift as isize;
+    (-max_shift..=max_shift)
+        .map(|shift| (shift, correlation(shift)))
+        .max_by(|a, b| a.1 .0.total_cmp(&b.1 .0))
+        .map_or((0, 0.0), |(shift, (_, rho))| (shift, rho.clamp(0.0, 1.0)))
+}
+
+/// Crossfade from `outgoing` into the start of `heads` (the incoming segment, already
+/// aligned with it), in place. `rho` is their correlation.
+fn crossfade_into(heads: &mut [&mut [f32]], outgoing: &[&[f32]], rho: f64) {
+    for (head, outgoing) in heads.iter_mut().zip(outgoing) {
+        let fade = outgoing.len();
+        for (i, (sample, outgoing)) in head.iter_mut().zip(outgoing.iter()).enumerate() {
+            // Gains with g_in^2 + g_out^2 + 2*rho*g_in*g_out = 1: linear for coherent
+            // signals, equal-power for uncorrelated ones
+            let w = (i as f64 + 0.5) / fade as f64;
+            let norm = (w * w + (1.0 - w) * (1.0 - w) + 2.0 * rho * w * (1.0 - w)).sqrt();
+            *sample = ((w * *sample as f64 + (1.0 - w) * *outgoing as f64) / norm) as f32;
+        }
+    }
+}
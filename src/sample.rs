@@ -0,0 +1,201 @@
+use crate::ffi;
+use cxx::memory::UniquePtrTarget;
+use cxx::UniquePtr;
+use std::pin::Pin;
+
+mod private {
+    pub trait Sealed {}
+    impl Sealed for f32 {}
+    impl Sealed for f64 {}
+}
+
+/// Sample types the stretcher processes natively: `f32` and `f64`.
+///
+/// Each maps to its own instantiation of the C++ `SignalsmithStretch` template, so
+/// `Stretch<C, f64>` takes and produces `f64` audio without conversion buffers.
+/// Configuration values (sample rate, transpose) are passed as `f32` for both.
+pub trait StretchSample: Copy + Default + 'static + private::Sealed {
+    /// The C++ stretcher instantiated for this sample type.
+    #[doc(hidden)]
+    type Core: UniquePtrTarget;
+
+    #[doc(hidden)]
+    fn new_core() -> UniquePtr<Self::Core>;
+    #[doc(hidden)]
+    fn new_core_with_seed(seed: i64) -> UniquePtr<Self::Core>;
+    #[doc(hidden)]
+    fn core_object_size() -> usize;
+
+    #[doc(hidden)]
+    fn block_samples(core: &Self::Core) -> i32;
+    #[doc(hidden)]
+    fn interval_samples(core: &Self::Core) -> i32;
+    #[doc(hidden)]
+    fn input_latency(core: &Self::Core) -> i32;
+    #[doc(hidden)]
+    fn output_latency(core: &Self::Core) -> i32;
+
+    #[doc(hidden)]
+    fn reset(core: Pin<&mut Self::Core>);
+    #[doc(hidden)]
+    fn preset_default(core: Pin<&mut Self::Core>, channels: i32, sample_rate: f32);
+    #[doc(hidden)]
+    fn preset_cheaper(core: Pin<&mut Self::Core>, channels: i32, sample_rate: f32);
+    #[doc(hidden)]
+    fn configure(core: Pin<&mut Self::Core>, channels: i32, block_samples: i32, interval_samples: i32);
+    #[doc(hidden)]
+    fn set_transpose_factor(core: Pin<&mut Self::Core>, multiplier: f32, tonality_limit: f32);
+    #[doc(hidden)]
+    fn set_transpose_semitones(core: Pin<&mut Self::Core>, semitones: f32, tonality_limit: f32);
+
+    #[doc(hidden)]
+    unsafe fn process(
+        core: Pin<&mut Self::Core>,
+        inputs: *const *const Self,
+        input_samples: i32,
+        outputs: *mut *mut Self,
+        output_samples: i32,
+        channels: i32,
+    );
+    #[doc(hidden)]
+    unsafe fn seek(
+        core: Pin<&mut Self::Core>,
+        inputs: *const *const Self,
+        input_samples: i32,
+        playback_rate: f64,
+        channels: i32,
+    );
+    #[doc(hidden)]
+    unsafe fn flush(
+        core: Pin<&mut Self::Core>,
+        outputs: *mut *mut Self,
+        output_samples: i32,
+        channels: i32,
+    );
+}
+
+macro_rules! impl_stretch_sample {
+    (
+        $sample:ty,
+        $core:ty,
+        new: $new:ident,
+        new_with_seed: $new_with_seed:ident,
+        object_size: $object_size:ident,
+        process: $process:ident,
+        seek: $seek:ident,
+        flush: $flush:ident $(,)?
+    ) => {
+        impl StretchSample for $sample {
+            type Core = $core;
+
+            fn new_core() -> UniquePtr<Self::Core> {
+                ffi::$new()
+            }
+
+            fn new_core_with_seed(seed: i64) -> UniquePtr<Self::Core> {
+                ffi::$new_with_seed(seed)
+            }
+
+            fn core_object_size() -> usize {
+                ffi::$object_size()
+            }
+
+            fn block_samples(core: &Self::Core) -> i32 {
+                core.blockSamples()
+            }
+
+            fn interval_samples(core: &Self::Core) -> i32 {
+                core.intervalSamples()
+            }
+
+            fn input_latency(core: &Self::Core) -> i32 {
+                core.inputLatency()
+            }
+
+            fn output_latency(core: &Self::Core) -> i32 {
+                core.outputLatency()
+            }
+
+            fn reset(core: Pin<&mut Self::Core>) {
+                core.reset();
+            }
+
+            fn preset_default(core: Pin<&mut Self::Core>, channels: i32, sample_rate: f32) {
+                core.presetDefault(channels, sample_rate as $sample);
+            }
+
+            fn preset_cheaper(core: Pin<&mut Self::Core>, channels: i32, sample_rate: f32) {
+                core.presetCheaper(channels, sample_rate as $sample);
+            }
+
+            fn configure(
+                core: Pin<&mut Self::Core>,
+                channels: i32,
+                block_samples: i32,
+                interval_samples: i32,
+            ) {
+                core.configure(channels, block_samples, interval_samples);
+            }
+
+            fn set_transpose_factor(core: Pin<&mut Self::Core>, multiplier: f32, tonality_limit: f32) {
+                core.setTransposeFactor(multiplier as $sample, tonality_limit as $sample);
+            }
+
+            fn set_transpose_semitones(core: Pin<&mut Self::Core>, semitones: f32, tonality_limit: f32) {
+                core.setTransposeSemitones(semitones as $sample, tonality_limit as $sample);
+            }
+
+            unsafe fn process(
+                core: Pin<&mut Self::Core>,
+                inputs: *const *const Self,
+                input_samples: i32,
+                outputs: *mut *mut Self,
+                output_samples: i32,
+                channels: i32,
+            ) {
+                ffi::$process(core, inputs, input_samples, outputs, output_samples, channels);
+            }
+
+            unsafe fn seek(
+                core: Pin<&mut Self::Core>,
+                inputs: *const *const Self,
+                input_samples: i32,
+                playback_rate: f64,
+                channels: i32,
+            ) {
+                ffi::$seek(core, inputs, input_samples, playback_rate, channels);
+            }
+
+            unsafe fn flush(
+                core: Pin<&mut Self::Core>,
+                outputs: *mut *mut Self,
+                output_samples: i32,
+                channels: i32,
+            ) {
+                ffi::$flush(core, outputs, output_samples, channels);
+            }
+        }
+    };
+}
+
+impl_stretch_sample!(
+    f32,
+    ffi::SignalsmithStretchFloat,
+    new: new_signalsmith_stretch,
+    new_with_seed: new_signalsmith_stretch_with_seed,
+    object_size: signalsmith_stretch_object_size,
+    process: signalsmith_stretch_process,
+    seek: signalsmith_stretch_seek,
+    flush: signalsmith_stretch_flush,
+);
+
+impl_stretch_sample!(
+    f64,
+    ffi::SignalsmithStretchDouble,
+    new: new_signalsmith_stretch_double,
+    new_with_seed: new_signalsmith_stretch_double_with_seed,
+    object_size: signalsmith_stretch_double_object_size,
+    process: signalsmith_stretch_double_process,
+    seek: signalsmith_stretch_double_seek,
+    flush: signalsmith_stretch_double_flush,
+);
@@ -0,0 +1,203 @@
+//! Phase-coherent stretching of stems.
+//!
+//! Separate stretchers make their own phase decisions, so drum, bass and vocal stems
+//! stretched independently no longer sum to the stretched mix. Within one stretcher the
+//! analysis is shared: spectral peaks are found on the energy summed over all channels,
+//! and every channel follows the same frequency map and phase-lock references.
+//!
+//! `LinkedStems` lays several multichannel stems out as consecutive channels of one
+//! `Stretch<C>` (three stereo stems make `C = 6`), so all of them see the same decisions
+//! every block. Offline, `ParallelRender::render_stems` still spreads the work across
+//! cores by splitting the file in time rather than by stem, and aligns every segment
+//! boundary with a single shift for all channels, so the stems stay linked there too.
+//!
+//! Linking serialises the stems: one instance processes all `C` channels on the calling
+//! thread, so a block costs about what the stems' separate stretchers would together,
+//! but none of it can run on another core. In real time, if the stems don't have to
+//! sum back to the mix (they are monitored or exported separately), a `Stretch` per stem,
+//! each on its own thread, keeps them parallel at the cost of coherence.
+
+use crate::sample::StretchSample;
+use crate::stretch::Stretch;
+use std::array;
+use std::ops::Range;
+
+/// Several stems processed as the channels of one stretcher, sharing its analysis.
+///
+/// See the module documentation.
+pub struct LinkedStems<const C: usize, T: StretchSample = f32> {
+    stretch: Stretch<C, T>,
+    // First channel of each stem, and C at the end
+    offsets: Vec<usize>,
+    // (stem, channel within the stem) for every channel of the stretcher
+    channels: [(usize, usize); C],
+}
+
+impl<const C: usize, T: StretchSample> LinkedStems<C, T> {
+    /// Link stems with `stem_channels` channels each, in order, onto `stretch`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the stem channel counts don't add up to `C`.
+    pub fn new(stretch: Stretch<C, T>, stem_channels: &[usize]) -> Self {
+        assert_eq!(
+            stem_channels.iter().sum::<usize>(),
+            C,
+            "stem channel counts must add up to the stretcher's {} channels",
+            C
+        );
+        let mut offsets = Vec::with_capacity(stem_channels.len() + 1);
+        let mut offset = 0;
+        for &count in stem_channels {
+            offsets.push(offset);
+            offset += count;
+        }
+        offsets.push(C);
+        let channels = array::from_fn(|channel| {
+            let stem = offsets.partition_point(|&start| start <= channel) - 1;
+            (stem, channel - offsets[stem])
+        });
+        Self {
+            stretch,
+            offsets,
+            channels,
+        }
+    }
+
+    /// Number of stems.
+    pub fn stems(&self) -> usize {
+        self.offsets.len() - 1
+    }
+
+    /// The stretcher channels holding `stem`.
+    pub fn stem_channels(&self, stem: usize) -> Range<usize> {
+        self.offsets[stem]..self.offsets[stem + 1]
+    }
+
+    /// Process `input_samples` of every stem into `output_samples` of every stem.
+    ///
+    /// Stems are `Vec<Vec<T>>` (one `Vec` per channel), as in `Stretch::process_vec`;
+    /// output channels are resized to `output_samples`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the stems don't match the layout or an input is too short.
+    pub fn process(
+        &mut self,
+        inputs: &[Vec<Vec<T>>],
+        input_samples: i32,
+        outputs: &mut [Vec<Vec<T>>],
+        output_samples: i32,
+    ) {
+        self.check_layout(inputs, "input");
+        self.check_layout(outputs, "output");
+        for (stem, channels) in inputs.iter().enumerate() {
+            assert!(
+                channels
+                    .iter()
+                    .all(|channel| channel.len() >= input_samples as usize),
+                "input stem {} is shorter than input_samples {}",
+                stem,
+                input_samples
+            );
+        }
+        for channel in outputs.iter_mut().flatten() {
+            channel.resize(output_samples as usize, T::default());
+        }
+
+        let input_ptrs: [*const T; C] = array::from_fn(|i| {
+            let (stem, channel) = self.channels[i];
+            inputs[stem][channel].as_ptr()
+        });
+        let mut output_ptrs: [*mut T; C] = array::from_fn(|i| {
+            let (stem, channel) = self.channels[i];
+            outputs[stem][channel].as_mut_ptr()
+        });
+        unsafe {
+            self.stretch.process_raw(
+                input_ptrs.as_ptr(),
+                input_samples,
+                output_ptrs.as_mut_ptr(),
+                output_samples,
+            );
+        }
+    }
+
+    /// Provide previous input of every stem ("pre-roll"), as `Stretch::seek_vec`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the stems don't match the layout or an input is too short.
+    pub fn seek(&mut self, inputs: &[Vec<Vec<T>>], input_samples: i32, playback_rate: f64) {
+        self.check_layout(inputs, "input");
+        for (stem, channels) in inputs.iter().enumerate() {
+            assert!(
+                channels
+                    .iter()
+                    .all(|channel| channel.len() >= input_samples as usize),
+                "input stem {} is shorter than input_samples {}",
+                stem,
+                input_samples
+            );
+        }
+        let input_ptrs: [*const T; C] = array::from_fn(|i| {
+            let (stem, channel) = self.channels[i];
+            inputs[stem][channel].as_ptr()
+        });
+        self.stretch
+            .seek_raw(input_ptrs.as_ptr(), input_samples, playback_rate);
+    }
+
+    /// Flush remaining output of every stem, as `Stretch::flush_vec`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the stems don't match the layout.
+    pub fn flush(&mut self, outputs: &mut [Vec<Vec<T>>], output_samples: i32) {
+        self.check_layout(outputs, "output");
+        for channel in outputs.iter_mut().flatten() {
+            channel.resize(output_samples as usize, T::default());
+        }
+        let mut output_ptrs: [*mut T; C] = array::from_fn(|i| {
+            let (stem, channel) = self.channels[i];
+            outputs[stem][channel].as_mut_ptr()
+        });
+        self.stretch
+            .flush_raw(output_ptrs.as_mut_ptr(), output_samples);
+    }
+
+    /// The underlying stretcher, for latency queries, transpose and reset.
+    pub fn stretch(&self) -> &Stretch<C, T> {
+        &self.stretch
+    }
+
+    /// Mutable access to the underlying stretcher.
+    pub fn stretch_mut(&mut self) -> &mut Stretch<C, T> {
+        &mut self.stretch
+    }
+
+    /// Unwrap into the underlying stretcher.
+    pub fn into_inner(self) -> Stretch<C, T> {
+        self.stretch
+    }
+
+    fn check_layout(&self, stems: &[Vec<Vec<T>>], kind: &str) {
+        assert_eq!(
+            stems.len(),
+            self.stems(),
+            "expected {} {} stems, got {}",
+            self.stems(),
+            kind,
+            stems.len()
+        );
+        for (stem, channels) in stems.iter().enumerate() {
+            assert_eq!(
+                channels.len(),
+                self.stem_channels(stem).len(),
+                "{} stem {} has the wrong number of channels",
+                kind,
+                stem
+            );
+        }
+    }
+}
@@ -1,77 +1,217 @@
-use crate::ffi;
+#[cfg(feature = "custom-allocator")]
+use crate::allocator::{AllocatorScope, StretchAllocator};
+use crate::denormals::{self, DenormalGuard};
+use crate::latency::{self, LatencyReport};
+use crate::memory::{self, MemoryUsage};
+use crate::monitor::DeadlineMonitor;
+use crate::sample::StretchSample;
+use crate::util::buffer::PlanarBuffer;
 use std::array;
 use std::marker::PhantomData;
+use std::sync::Arc;
+use std::time::Instant;
 
 /// Configuration builder for Stretch.
 ///
 /// Used to configure a Stretch instance with specific parameters.
 ///
-/// The type parameter C specifies the number of audio channels.
-pub struct StretchBuilder<const C: usize> {
-    inner: cxx::UniquePtr<ffi::SignalsmithStretchFloat>,
+/// The type parameter C specifies the number of audio channels, and T the
+/// sample type (`f32` by default, or `f64`).
+pub struct StretchBuilder<const C: usize, T: StretchSample = f32> {
+    inner: cxx::UniquePtr<T::Core>,
+    #[cfg(feature = "custom-allocator")]
+    allocator: Option<StretchAllocator>,
+    flush_denormals: bool,
+    monitor: Option<Arc<DeadlineMonitor>>,
+    // Frequency multiplier and tonality limit as last set, before rate compensation
+    transpose: (f32, f32),
+    rate_ratio: f32,
 }
 
-impl<const C: usize> StretchBuilder<C> {
+impl<const C: usize, T: StretchSample> StretchBuilder<C, T> {
     /// Create a new builder with default settings for C channels.
     pub fn new() -> Self {
+        let _span = span!(DEBUG, "stretch_new", channels = C, sample = std::any::type_name::<T>());
         Self {
-            inner: ffi::new_signalsmith_stretch(),
+            inner: T::new_core(),
+            #[cfg(feature = "custom-allocator")]
+            allocator: None,
+            flush_denormals: denormals::flush_denormals_default(),
+            monitor: None,
+            transpose: (1.0, 0.0),
+            rate_ratio: 1.0,
         }
     }
 
     /// Create a builder with a specific random seed for C channels.
     pub fn with_seed(seed: i64) -> Self {
+        let _span = span!(DEBUG, "stretch_new", channels = C, sample = std::any::type_name::<T>());
         Self {
-            inner: ffi::new_signalsmith_stretch_with_seed(seed),
+            inner: T::new_core_with_seed(seed),
+            #[cfg(feature = "custom-allocator")]
+            allocator: None,
+            flush_denormals: denormals::flush_denormals_default(),
+            monitor: None,
+            transpose: (1.0, 0.0),
+            rate_ratio: 1.0,
+        }
+    }
+
+    /// Create a builder whose C++ allocations (including the stretcher object itself)
+    /// come from `allocator`.
+    #[cfg(feature = "custom-allocator")]
+    pub fn new_in(allocator: StretchAllocator) -> Self {
+        let _span = span!(DEBUG, "stretch_new", channels = C, sample = std::any::type_name::<T>());
+        let inner = {
+            let _scope = AllocatorScope::enter(Some(&allocator));
+            T::new_core()
+        };
+        Self {
+            inner,
+            allocator: Some(allocator),
+            flush_denormals: denormals::flush_denormals_default(),
+            monitor: None,
+            transpose: (1.0, 0.0),
+            rate_ratio: 1.0,
+        }
+    }
+
+    /// Create a builder with a specific random seed, allocating from `allocator`.
+    #[cfg(feature = "custom-allocator")]
+    pub fn with_seed_in(seed: i64, allocator: StretchAllocator) -> Self {
+        let _span = span!(DEBUG, "stretch_new", channels = C, sample = std::any::type_name::<T>());
+        let inner = {
+            let _scope = AllocatorScope::enter(Some(&allocator));
+            T::new_core_with_seed(seed)
+        };
+        Self {
+            inner,
+            allocator: Some(allocator),
+            flush_denormals: denormals::flush_denormals_default(),
+            monitor: None,
+            transpose: (1.0, 0.0),
+            rate_ratio: 1.0,
         }
     }
 
     /// Configure with default presets based on sample rate.
     pub fn preset_default(mut self, sample_rate: f32) -> Self {
-        self.inner.pin_mut().presetDefault(C as i32, sample_rate);
+        let _span = span!(DEBUG, "stretch_configure", preset = "default", channels = C, sample_rate);
+        #[cfg(feature = "custom-allocator")]
+        let _scope = AllocatorScope::enter(self.allocator.as_ref());
+        T::preset_default(self.inner.pin_mut(), C as i32, sample_rate);
         self
     }
 
     /// Configure with cheaper presets based on sample rate (less CPU intensive).
     pub fn preset_cheaper(mut self, sample_rate: f32) -> Self {
-        self.inner.pin_mut().presetCheaper(C as i32, sample_rate);
+        let _span = span!(DEBUG, "stretch_configure", preset = "cheaper", channels = C, sample_rate);
+        #[cfg(feature = "custom-allocator")]
+        let _scope = AllocatorScope::enter(self.allocator.as_ref());
+        T::preset_cheaper(self.inner.pin_mut(), C as i32, sample_rate);
         self
     }
 
+    /// Configure for at most `max_ms` of input plus output latency, with the longest
+    /// block that fits and the cheaper preset's overlap (see `ssstretch::latency`).
+    ///
+    /// This is not the cheapest configuration that fits: cost falls with the block
+    /// length, so that would always be the smallest block, which smears transients and
+    /// blurs low notes. The block length is left as the quality setting and spent up to
+    /// the budget; cost is kept down for that block by snapping it to an FFT size and using
+    /// the cheaper preset's overlap. For a lower cost, pass a smaller `max_ms`.
+    ///
+    /// `sample_rate` is the input rate. Call `output_rate` first when it differs: output
+    /// latency is then counted in input samples, as `Stretch::latency_report` does.
+    ///
+    /// If even the smallest block doesn't fit, that block is used; check
+    /// `Stretch::latency_report` for the latency actually reached.
+    pub fn preset_for_latency(mut self, sample_rate: f32, max_ms: f32) -> Self {
+        let budget = (max_ms * 0.001 * sample_rate) as i32;
+        let mut block = memory::fft_size_below(budget.max(1) as usize).max(latency::MIN_BLOCK_SAMPLES);
+        loop {
+            let interval = ((block as f32 * latency::INTERVAL_RATIO) as i32).max(1);
+            self = self.configure(block as i32, interval);
+            let output_latency = (T::output_latency(&self.inner) as f32 * self.rate_ratio).round() as i32;
+            let reached = T::input_latency(&self.inner) + output_latency;
+            if reached <= budget || block <= latency::MIN_BLOCK_SAMPLES {
+                return self;
+            }
+            block = memory::fft_size_below(block - 1);
+        }
+    }
+
     /// Manually configure the stretcher with specific parameters.
     pub fn configure(mut self, block_samples: i32, interval_samples: i32) -> Self {
-        self.inner
-            .pin_mut()
-            .configure(C as i32, block_samples, interval_samples);
+        let _span = span!(
+            DEBUG,
+            "stretch_configure",
+            channels = C,
+            block_samples,
+            interval_samples
+        );
+        #[cfg(feature = "custom-allocator")]
+        let _scope = AllocatorScope::enter(self.allocator.as_ref());
+        T::configure(self.inner.pin_mut(), C as i32, block_samples, interval_samples);
         self
     }
 
     /// Set the frequency multiplier and an optional tonality limit.
     pub fn transpose_factor(mut self, multiplier: f32, tonality_limit: Option<f32>) -> Self {
-        self.inner
-            .pin_mut()
-            .setTransposeFactor(multiplier, tonality_limit.unwrap_or(0.0));
+        self.transpose = (multiplier, tonality_limit.unwrap_or(0.0));
+        T::set_transpose_factor(self.inner.pin_mut(), multiplier, self.transpose.1);
         self
     }
 
     /// Set the frequency shift in semitones and an optional tonality limit.
     pub fn transpose_semitones(mut self, semitones: f32, tonality_limit: Option<f32>) -> Self {
-        self.inner
-            .pin_mut()
-            .setTransposeSemitones(semitones, tonality_limit.unwrap_or(0.0));
+        self.transpose = (2f32.powf(semitones / 12.0), tonality_limit.unwrap_or(0.0));
+        T::set_transpose_semitones(self.inner.pin_mut(), semitones, self.transpose.1);
+        self
+    }
+
+    /// Produce output at `output_rate` from input at `input_rate`, in the same pass
+    /// instead of a separate resampler (see `Stretch::set_output_rate`).
+    pub fn output_rate(mut self, input_rate: f32, output_rate: f32) -> Self {
+        self.rate_ratio = input_rate / output_rate;
+        self
+    }
+
+    /// Flush denormals to zero while processing (see `ssstretch::denormals`).
+    ///
+    /// Defaults to `denormals::flush_denormals_default()`.
+    pub fn flush_denormals(mut self, enabled: bool) -> Self {
+        self.flush_denormals = enabled;
+        self
+    }
+
+    /// Time every `process` and `flush` call against its deadline (see `DeadlineMonitor`).
+    pub fn monitor(mut self, monitor: Arc<DeadlineMonitor>) -> Self {
+        self.monitor = Some(monitor);
         self
     }
 
     /// Build a Stretch instance with the configured parameters.
-    pub fn build(self) -> Stretch<C> {
-        Stretch {
+    pub fn build(self) -> Stretch<C, T> {
+        let mut stretch = Stretch {
             inner: self.inner,
+            #[cfg(feature = "custom-allocator")]
+            allocator: self.allocator,
+            flush_denormals: self.flush_denormals,
+            monitor: self.monitor,
+            transpose: self.transpose,
+            rate_ratio: 1.0,
             _marker: PhantomData,
+        };
+        if self.rate_ratio != 1.0 {
+            stretch.rate_ratio = self.rate_ratio;
+            stretch.apply_transpose();
         }
+        stretch
     }
 }
 
-impl<const C: usize> Default for StretchBuilder<C> {
+impl<const C: usize, T: StretchSample> Default for StretchBuilder<C, T> {
     fn default() -> Self {
         Self::new()
     }
@@ -80,67 +220,164 @@ impl<const C: usize> Default for StretchBuilder<C> {
 /// Main struct for time-stretching and pitch-shifting audio.
 ///
 /// This struct is generic over the number of channels, which is
-/// statically known at compile time for better performance.
+/// statically known at compile time for better performance, and over the
+/// sample type: `Stretch<C>` processes `f32`, `Stretch<C, f64>` processes `f64`.
 ///
 /// Use the `StretchBuilder` to configure and create instances.
-pub struct Stretch<const CHANNELS: usize> {
-    pub(crate) inner: cxx::UniquePtr<ffi::SignalsmithStretchFloat>,
-    pub(crate) _marker: PhantomData<[(); CHANNELS]>,
+pub struct Stretch<const CHANNELS: usize, T: StretchSample = f32> {
+    pub(crate) inner: cxx::UniquePtr<T::Core>,
+    // Declared after `inner` so the C++ object is freed before its allocator
+    #[cfg(feature = "custom-allocator")]
+    pub(crate) allocator: Option<StretchAllocator>,
+    pub(crate) flush_denormals: bool,
+    pub(crate) monitor: Option<Arc<DeadlineMonitor>>,
+    // Frequency multiplier and tonality limit as last set, before rate compensation
+    pub(crate) transpose: (f32, f32),
+    // Input sample rate over output sample rate
+    pub(crate) rate_ratio: f32,
+    pub(crate) _marker: PhantomData<([(); CHANNELS], T)>,
 }
 
-impl<const CHANNELS: usize> Stretch<CHANNELS> {
+impl<const CHANNELS: usize, T: StretchSample> Stretch<CHANNELS, T> {
     /// Create a new Stretch instance with default configuration for
     /// the specified number of channels and sample rate.
     pub fn new(sample_rate: f32) -> Self {
-        StretchBuilder::<CHANNELS>::new()
+        StretchBuilder::<CHANNELS, T>::new()
             .preset_default(sample_rate)
             .build()
     }
 
     /// Create a new Stretch instance with a specified random seed.
     pub fn with_seed(seed: i64, sample_rate: f32) -> Self {
-        StretchBuilder::<CHANNELS>::with_seed(seed)
+        StretchBuilder::<CHANNELS, T>::with_seed(seed)
+            .preset_default(sample_rate)
+            .build()
+    }
+
+    /// Create a new Stretch instance with default configuration whose C++
+    /// allocations come from `allocator`.
+    #[cfg(feature = "custom-allocator")]
+    pub fn new_in(sample_rate: f32, allocator: StretchAllocator) -> Self {
+        StretchBuilder::<CHANNELS, T>::new_in(allocator)
             .preset_default(sample_rate)
             .build()
     }
 
+    /// The allocator this instance's C++ allocations come from, if any.
+    #[cfg(feature = "custom-allocator")]
+    pub fn allocator(&self) -> Option<&StretchAllocator> {
+        self.allocator.as_ref()
+    }
+
     /// Reset the instance to its initial state.
     pub fn reset(&mut self) {
-        self.inner.pin_mut().reset();
+        T::reset(self.inner.pin_mut());
     }
 
     /// Get the block size in samples.
     pub fn block_samples(&self) -> i32 {
-        self.inner.blockSamples()
+        T::block_samples(&self.inner)
     }
 
     /// Get the interval size in samples.
     pub fn interval_samples(&self) -> i32 {
-        self.inner.intervalSamples()
+        T::interval_samples(&self.inner)
     }
 
     /// Get the input latency in samples.
     pub fn input_latency(&self) -> i32 {
-        self.inner.inputLatency()
+        T::input_latency(&self.inner)
     }
 
     /// Get the output latency in samples.
     pub fn output_latency(&self) -> i32 {
-        self.inner.outputLatency()
+        T::output_latency(&self.inner)
+    }
+
+    /// The configured sizes, total latency and estimated processing cost at `sample_rate`
+    /// (the input rate). With `set_output_rate`, the output latency is converted from
+    /// output samples to input samples before it is added.
+    pub fn latency_report(&self, sample_rate: f32) -> LatencyReport {
+        let output_latency = (self.output_latency() as f32 * self.rate_ratio).round() as i32;
+        let latency_samples = self.input_latency() + output_latency;
+        LatencyReport {
+            block_samples: self.block_samples(),
+            interval_samples: self.interval_samples(),
+            latency_samples,
+            latency_ms: latency_samples as f32 * 1000.0 / sample_rate,
+            relative_cpu: latency::relative_cpu(sample_rate, self.block_samples(), self.interval_samples()),
+        }
+    }
+
+    /// Heap memory held by this instance, by category, modelled from its block and
+    /// interval sizes (see `MemoryUsage`).
+    pub fn memory_usage(&self) -> MemoryUsage {
+        MemoryUsage::predict_for::<T>(CHANNELS, self.block_samples(), self.interval_samples())
+    }
+
+    /// The deadline monitor timing this instance's calls, if any.
+    pub fn monitor(&self) -> Option<&Arc<DeadlineMonitor>> {
+        self.monitor.as_ref()
+    }
+
+    /// Start (or with `None`, stop) timing `process` and `flush` calls against their deadline.
+    pub fn set_monitor(&mut self, monitor: Option<Arc<DeadlineMonitor>>) {
+        self.monitor = monitor;
+    }
+
+    /// Whether `process`, `seek` and `flush` run with denormals flushed to zero.
+    pub fn flush_denormals(&self) -> bool {
+        self.flush_denormals
+    }
+
+    /// Flush denormals to zero while processing, restoring the caller's
+    /// floating-point state after each call.
+    pub fn set_flush_denormals(&mut self, enabled: bool) {
+        self.flush_denormals = enabled;
     }
 
     /// Set the frequency multiplier and an optional tonality limit.
     pub fn set_transpose_factor(&mut self, multiplier: f32, tonality_limit: Option<f32>) {
-        self.inner
-            .pin_mut()
-            .setTransposeFactor(multiplier, tonality_limit.unwrap_or(0.0));
+        self.transpose = (multiplier, tonality_limit.unwrap_or(0.0));
+        self.apply_transpose();
     }
 
     /// Set the frequency shift in semitones and an optional tonality limit.
     pub fn set_transpose_semitones(&mut self, semitones: f32, tonality_limit: Option<f32>) {
-        self.inner
-            .pin_mut()
-            .setTransposeSemitones(semitones, tonality_limit.unwrap_or(0.0));
+        self.transpose = (2f32.powf(semitones / 12.0), tonality_limit.unwrap_or(0.0));
+        if self.rate_ratio == 1.0 {
+            T::set_transpose_semitones(self.inner.pin_mut(), semitones, self.transpose.1);
+        } else {
+            self.apply_transpose();
+        }
+    }
+
+    /// Produce output at `output_rate` from input at `input_rate`.
+    ///
+    /// The stretcher already resynthesises every output sample, so the rate change costs
+    /// nothing extra: the transpose is scaled by `input_rate / output_rate`, keeping pitch
+    /// as set, and output buffer lengths count samples at `output_rate`. To play at the
+    /// original speed, make outputs `output_rate / input_rate` times as long as inputs.
+    /// `output_latency` is in output samples. Tonality limits stay fractions of the input
+    /// rate: the core compares them with input frequencies, which it sees at the input
+    /// rate whatever the output rate, so they are passed on unchanged.
+    pub fn set_output_rate(&mut self, input_rate: f32, output_rate: f32) {
+        self.rate_ratio = input_rate / output_rate;
+        self.apply_transpose();
+    }
+
+    /// Output sample rate over input sample rate (1 unless set with `set_output_rate`).
+    pub fn output_rate_ratio(&self) -> f32 {
+        1.0 / self.rate_ratio
+    }
+
+    fn apply_transpose(&mut self) {
+        let (multiplier, tonality_limit) = self.transpose;
+        T::set_transpose_factor(
+            self.inner.pin_mut(),
+            multiplier * self.rate_ratio,
+            tonality_limit,
+        );
     }
 
     /// Process audio data, stretching time and/or shifting pitch.
@@ -153,12 +390,12 @@ impl<const CHANNELS: usize> Stretch<CHANNELS> {
     /// Panics if the input arrays have different lengths, or if the output arrays have different lengths.
     pub fn process<'input, 'output: 'input>(
         &mut self,
-        input_channels: [&'input [f32]; CHANNELS],
-        output_channels: &mut [&'output mut [f32]; CHANNELS],
+        input_channels: [&'input [T]; CHANNELS],
+        output_channels: &mut [&'output mut [T]; CHANNELS],
     ) {
         // Create stack-allocated arrays of pointers - no heap allocation
-        let input_ptrs: [*const f32; CHANNELS] = array::from_fn(|i| input_channels[i].as_ptr());
-        let mut output_ptrs: [*mut f32; CHANNELS] =
+        let input_ptrs: [*const T; CHANNELS] = array::from_fn(|i| input_channels[i].as_ptr());
+        let mut output_ptrs: [*mut T; CHANNELS] =
             array::from_fn(|i| output_channels[i].as_mut_ptr());
 
         let input_samples = input_channels[0].len() as i32;
@@ -195,7 +432,7 @@ impl<const CHANNELS: usize> Stretch<CHANNELS> {
     /// # Panics
     ///
     /// Panics if the input arrays have different lengths.
-    pub fn seek(&mut self, inputs: [&[f32]; CHANNELS], playback_rate: f64) {
+    pub fn seek(&mut self, inputs: [&[T]; CHANNELS], playback_rate: f64) {
         // Create stack-allocated arrays of pointers - no heap allocation
         let mut input_ptrs = [std::ptr::null(); CHANNELS];
 
@@ -215,6 +452,7 @@ impl<const CHANNELS: usize> Stretch<CHANNELS> {
             );
         }
 
+
         // Make the FFI call using our raw method
         self.seek_raw(input_ptrs.as_ptr(), input_samples, playback_rate);
     }
@@ -224,7 +462,7 @@ impl<const CHANNELS: usize> Stretch<CHANNELS> {
     /// # Panics
     ///
     /// Panics if the output arrays have different lengths.
-    pub fn flush(&mut self, outputs: [&mut [f32]; CHANNELS]) {
+    pub fn flush(&mut self, outputs: [&mut [T]; CHANNELS]) {
         // Create stack-allocated arrays of pointers - no heap allocation
         let mut output_ptrs = [std::ptr::null_mut(); CHANNELS];
 
@@ -244,22 +482,33 @@ impl<const CHANNELS: usize> Stretch<CHANNELS> {
             );
         }
 
+
         // Make the FFI call using our raw method
         self.flush_raw(output_ptrs.as_mut_ptr(), output_samples);
     }
 }
 
-// For compatibility with Vec<Vec<f32>> format, we need a low-level processing interface
-impl<const C: usize> Stretch<C> {
+// For compatibility with Vec<Vec<T>> format, we need a low-level processing interface
+impl<const C: usize, T: StretchSample> Stretch<C, T> {
     // Low-level processing function that allows for safe handling of vectors
-    unsafe fn process_raw(
+    pub(crate) unsafe fn process_raw(
         &mut self,
-        input_ptrs: *const *const f32,
+        input_ptrs: *const *const T,
         input_samples: i32,
-        output_ptrs: *mut *mut f32,
+        output_ptrs: *mut *mut T,
         output_samples: i32,
     ) {
-        ffi::signalsmith_stretch_process(
+        let _span = span!(
+            TRACE,
+            "stretch_process",
+            channels = C,
+            samples_in = input_samples,
+            samples_out = output_samples,
+            ratio = output_samples as f64 / input_samples as f64
+        );
+        let _denormals = DenormalGuard::when(self.flush_denormals);
+        let start = self.monitor.as_ref().map(|_| Instant::now());
+        T::process(
             self.inner.pin_mut(),
             input_ptrs,
             input_samples,
@@ -267,11 +516,20 @@ impl<const C: usize> Stretch<C> {
             output_samples,
             C as i32,
         );
+        self.record_call(start, output_samples);
     }
 
-    fn seek_raw(&mut self, input_ptrs: *const *const f32, input_samples: i32, playback_rate: f64) {
+    pub(crate) fn seek_raw(&mut self, input_ptrs: *const *const T, input_samples: i32, playback_rate: f64) {
+        let _span = span!(
+            TRACE,
+            "stretch_seek",
+            channels = C,
+            samples_in = input_samples,
+            playback_rate
+        );
+        let _denormals = DenormalGuard::when(self.flush_denormals);
         unsafe {
-            ffi::signalsmith_stretch_seek(
+            T::seek(
                 self.inner.pin_mut(),
                 input_ptrs,
                 input_samples,
@@ -281,18 +539,73 @@ impl<const C: usize> Stretch<C> {
         }
     }
 
-    fn flush_raw(&mut self, output_ptrs: *mut *mut f32, output_samples: i32) {
+    pub(crate) fn flush_raw(&mut self, output_ptrs: *mut *mut T, output_samples: i32) {
+        let _span = span!(TRACE, "stretch_flush", channels = C, samples_out = output_samples);
+        let _denormals = DenormalGuard::when(self.flush_denormals);
+        let start = self.monitor.as_ref().map(|_| Instant::now());
         unsafe {
-            ffi::signalsmith_stretch_flush(
+            T::flush(
                 self.inner.pin_mut(),
                 output_ptrs,
                 output_samples,
                 C as i32,
             );
+            }
+        self.record_call(start, output_samples);
+    }
+
+    // Report a call started at `start` (set only when monitored) to the deadline monitor
+    fn record_call(&self, start: Option<Instant>, output_samples: i32) {
+        if let (Some(monitor), Some(start)) = (&self.monitor, start) {
+            monitor.record(output_samples.max(0) as usize, start.elapsed());
         }
     }
 
-    /// Process audio data with Vec<Vec<f32>> format (non-interleaved).
+    /// Process a whole planar input buffer into a whole planar output buffer.
+    ///
+    /// This is the cheapest checked path for small callbacks: `PlanarBuffer` guarantees
+    /// the channel count and lengths when it is created, so nothing is validated per
+    /// call and the channel pointers come straight from its storage.
+    pub fn process_planar(&mut self, input: &PlanarBuffer<C, T>, output: &mut PlanarBuffer<C, T>) {
+        let input_ptrs = input.channel_ptrs();
+        let mut output_ptrs = output.channel_ptrs_mut();
+        unsafe {
+            self.process_raw(
+                input_ptrs.as_ptr(),
+                input.frames() as i32,
+                output_ptrs.as_mut_ptr(),
+                output.frames() as i32,
+            );
+        }
+    }
+
+    /// Process from raw channel pointers with no checks at all.
+    ///
+    /// For callers which already hold per-channel pointers (from an audio device, or
+    /// buffers validated once up front) and want no per-call overhead beyond the C++ call.
+    ///
+    /// # Safety
+    ///
+    /// Every `inputs[i]` must be valid for reading `input_samples` samples, every
+    /// `outputs[i]` valid for writing `output_samples` samples, outputs must not overlap
+    /// each other or the inputs, and both counts must fit in an `i32`.
+    pub unsafe fn process_unchecked(
+        &mut self,
+        inputs: &[*const T; C],
+        input_samples: usize,
+        outputs: &[*mut T; C],
+        output_samples: usize,
+    ) {
+        let mut output_ptrs = *outputs;
+        self.process_raw(
+            inputs.as_ptr(),
+            input_samples as i32,
+            output_ptrs.as_mut_ptr(),
+            output_samples as i32,
+        );
+    }
+
+    /// Process audio data with Vec<Vec<T>> format (non-interleaved).
     ///
     /// Each inner Vec represents a channel of audio samples.
     /// The time stretch ratio is determined by the ratio of input_samples to output_samples.
@@ -302,9 +615,9 @@ impl<const C: usize> Stretch<C> {
     /// Panics if the number of input or output vectors is different from C.
     pub fn process_vec(
         &mut self,
-        inputs: &[Vec<f32>],
+        inputs: &[Vec<T>],
         input_samples: i32,
-        outputs: &mut [Vec<f32>],
+        outputs: &mut [Vec<T>],
         output_samples: i32,
     ) {
         assert_eq!(
@@ -336,7 +649,7 @@ impl<const C: usize> Stretch<C> {
 
         // Ensure output vectors have enough capacity
         for channel in outputs.iter_mut() {
-            channel.resize(output_samples as usize, 0.0);
+            channel.resize(output_samples as usize, T::default());
         }
 
         // Validate that each output channel has at least output_samples
@@ -351,17 +664,11 @@ impl<const C: usize> Stretch<C> {
             );
         }
 
-        // Create arrays of pointers to channel data
-        let mut input_ptrs = Vec::with_capacity(C);
-        let mut output_ptrs = Vec::with_capacity(C);
+        // Create stack-allocated arrays of pointers to channel data, so the
+        // steady-state path makes no heap allocations
+        let input_ptrs: [*const T; C] = array::from_fn(|i| inputs[i].as_ptr());
+        let mut output_ptrs: [*mut T; C] = array::from_fn(|i| outputs[i].as_mut_ptr());
 
-        for i in 0..C {
-            input_ptrs.push(inputs[i].as_ptr());
-        }
-
-        for i in 0..C {
-            output_ptrs.push(outputs[i].as_mut_ptr());
-        }
 
         // Process using the low-level API
         unsafe {
@@ -374,12 +681,12 @@ impl<const C: usize> Stretch<C> {
         }
     }
 
-    /// Seek with Vec<Vec<f32>> format (non-interleaved).
+    /// Seek with Vec<Vec<T>> format (non-interleaved).
     ///
     /// # Panics
     ///
     /// Panics if the number of input vectors is different from C.
-    pub fn seek_vec(&mut self, inputs: &[Vec<f32>], input_samples: i32, playback_rate: f64) {
+    pub fn seek_vec(&mut self, inputs: &[Vec<T>], input_samples: i32, playback_rate: f64) {
         assert_eq!(
             inputs.len(),
             C,
@@ -400,23 +707,20 @@ impl<const C: usize> Stretch<C> {
             );
         }
 
-        // Create arrays of pointers to channel data
-        let mut input_ptrs = Vec::with_capacity(C);
+        // Create stack-allocated arrays of pointers to channel data
+        let input_ptrs: [*const T; C] = array::from_fn(|i| inputs[i].as_ptr());
 
-        for i in 0..C {
-            input_ptrs.push(inputs[i].as_ptr());
-        }
 
         // Process using the low-level API
         self.seek_raw(input_ptrs.as_ptr(), input_samples, playback_rate);
     }
 
-    /// Flush with Vec<Vec<f32>> format (non-interleaved).
+    /// Flush with Vec<Vec<T>> format (non-interleaved).
     ///
     /// # Panics
     ///
     /// Panics if the number of output vectors is different from C.
-    pub fn flush_vec(&mut self, outputs: &mut [Vec<f32>], output_samples: i32) {
+    pub fn flush_vec(&mut self, outputs: &mut [Vec<T>], output_samples: i32) {
         assert_eq!(
             outputs.len(),
             C,
@@ -427,7 +731,7 @@ impl<const C: usize> Stretch<C> {
 
         // Ensure output vectors have enough capacity
         for channel in outputs.iter_mut() {
-            channel.resize(output_samples as usize, 0.0);
+            channel.resize(output_samples as usize, T::default());
         }
 
         // Validate that each output channel has at least output_samples
@@ -442,12 +746,9 @@ impl<const C: usize> Stretch<C> {
             );
         }
 
-        // Create arrays of pointers to channel data
-        let mut output_ptrs = Vec::with_capacity(C);
+        // Create stack-allocated arrays of pointers to channel data
+        let mut output_ptrs: [*mut T; C] = array::from_fn(|i| outputs[i].as_mut_ptr());
 
-        for i in 0..C {
-            output_ptrs.push(outputs[i].as_mut_ptr());
-        }
 
         // Process using the low-level API
         self.flush_raw(output_ptrs.as_mut_ptr(), output_samples);
@@ -0,0 +1,19 @@
+//! Spans for the `tracing` feature.
+//!
+//! `span!(LEVEL, "name", fields...)` enters a `tracing` span until the returned guard is
+//! dropped. Without the feature it expands to `()`, and the field expressions are not
+//! evaluated, so instrumented code costs nothing.
+
+#[cfg(feature = "tracing")]
+macro_rules! span {
+    ($level:ident, $($args:tt)*) => {
+        ::tracing::span!(::tracing::Level::$level, $($args)*).entered()
+    };
+}
+
+#[cfg(not(feature = "tracing"))]
+macro_rules! span {
+    ($level:ident, $($args:tt)*) => {
+        ()
+    };
+}
@@ -10,6 +10,13 @@ pub fn create_buffer(channels: usize, frames: usize) -> Vec<Vec<f32>> {
     buffer
 }
 
+/// Add `input * gain` into `output`, over the shorter of the two.
+pub fn mix_into(output: &mut [f32], input: &[f32], gain: f32) {
+    for (out, sample) in output.iter_mut().zip(input) {
+        *out += sample * gain;
+    }
+}
+
 /// Convert a multi-channel buffer into an array of slices.
 /// 
 /// Useful for passing to API methods that expect fixed-size arrays.
@@ -49,4 +56,65 @@ pub fn get_channel_slices_mut<'a, const C: usize>(buffer: &'a mut [Vec<f32>]) ->
         }
         result
     }
-}
\ No newline at end of file
+}
+
+/// Planar audio buffer for `C` channels of equal length, stored contiguously.
+///
+/// The channel count and lengths are fixed when it is created, so
+/// `Stretch::process_planar` can use it without checking anything per call.
+#[derive(Debug, Clone, PartialEq)]
+pub struct PlanarBuffer<const C: usize, T = f32> {
+    samples: Vec<T>,
+    frames: usize,
+}
+
+impl<const C: usize, T: Copy + Default> PlanarBuffer<C, T> {
+    /// A zeroed buffer of `frames` samples per channel.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `frames` doesn't fit the C++ API's `int` sample counts.
+    pub fn new(frames: usize) -> Self {
+        assert!(frames <= i32::MAX as usize, "{} frames is too long for one call", frames);
+        Self {
+            samples: vec![T::default(); C * frames],
+            frames,
+        }
+    }
+
+    /// Samples per channel.
+    pub fn frames(&self) -> usize {
+        self.frames
+    }
+
+    /// One channel's samples.
+    pub fn channel(&self, channel: usize) -> &[T] {
+        &self.samples[channel * self.frames..(channel + 1) * self.frames]
+    }
+
+    /// One channel's samples, mutably.
+    pub fn channel_mut(&mut self, channel: usize) -> &mut [T] {
+        &mut self.samples[channel * self.frames..(channel + 1) * self.frames]
+    }
+
+    /// All channels as slices.
+    pub fn channels(&self) -> [&[T]; C] {
+        array::from_fn(|channel| self.channel(channel))
+    }
+
+    /// All channels as mutable slices.
+    pub fn channels_mut(&mut self) -> [&mut [T]; C] {
+        let mut channels = self.samples.chunks_exact_mut(self.frames.max(1));
+        array::from_fn(|_| channels.next().unwrap_or_default())
+    }
+
+    pub(crate) fn channel_ptrs(&self) -> [*const T; C] {
+        let base = self.samples.as_ptr();
+        array::from_fn(|channel| base.wrapping_add(channel * self.frames))
+    }
+
+    pub(crate) fn channel_ptrs_mut(&mut self) -> [*mut T; C] {
+        let base = self.samples.as_mut_ptr();
+        array::from_fn(|channel| base.wrapping_add(channel * self.frames))
+    }
+}